@@ -0,0 +1,132 @@
+#include "testApp.h"
+#include "MTThreadPool.hpp"
+#include <chrono>
+
+namespace
+{
+const int ContainerCount = 8;
+const int ViewsPerContainer = 32;
+const int ParticlesPerView = 2048;
+const int StepsPerUpdate = 8;
+const int FrameCount = 100;
+}
+
+ParticleView::ParticleView(std::string name) : MTView(name)
+{
+	reset();
+}
+
+void ParticleView::reset()
+{
+	positions.assign(ParticlesPerView, glm::vec2(0, 0));
+	velocities.resize(ParticlesPerView);
+	for (int i = 0; i < ParticlesPerView; i++)
+	{
+		float angle = i * 0.618f;
+		velocities[i] = glm::vec2(std::cos(angle), std::sin(angle));
+	}
+}
+
+void ParticleView::update()
+{
+	const float dt = 1.0f / 60.0f;
+	for (int step = 0; step < StepsPerUpdate; step++)
+	{
+		for (int i = 0; i < ParticlesPerView; i++)
+		{
+			// Pulled towards the center, with a little drag:
+			auto& p = positions[i];
+			auto& v = velocities[i];
+			v -= p * (dt / (1.0f + glm::dot(p, p)));
+			v *= 0.999f;
+			p += v * dt;
+		}
+	}
+}
+
+double ParticleView::getChecksum() const
+{
+	double sum = 0;
+	for (auto& p : positions)
+	{
+		sum += p.x + p.y;
+	}
+	return sum;
+}
+
+void testApp::appWillRun()
+{
+	ofGLFWWindowSettings settings;
+	settings.setSize(400, 400);
+	window = createOffscreenWindow("Concurrent Update Benchmark", settings);
+
+	for (int c = 0; c < ContainerCount; c++)
+	{
+		auto container = MTView::CreateView<MTView>("Container");
+		for (int v = 0; v < ViewsPerContainer; v++)
+		{
+			auto view = MTView::CreateView<ParticleView>("Particles");
+			container->addSubview(view);
+			particleViews.push_back(view);
+		}
+		window->addSubview(container);
+		containers.push_back(container);
+	}
+	// Settle the layout before timing anything:
+	window->renderFrames(1);
+
+	double mainThreadTime = timeUpdates(FrameCount);
+	double expectedChecksum = getChecksum();
+	ofLogNotice("concurrentUpdateBenchmark") << "Main thread: " << ofToString(mainThreadTime, 2) << " ms/frame";
+
+	for (auto& container : containers)
+	{
+		container->setConcurrentUpdate(true);
+	}
+
+	int failures = 0;
+	auto maxWorkers = std::max(1u, std::thread::hardware_concurrency());
+	for (size_t workers = 1; workers <= maxWorkers; workers++)
+	{
+		MTThreadPool::shared().setNumThreads(workers);
+		double time = timeUpdates(FrameCount);
+		ofLogNotice("concurrentUpdateBenchmark") << workers << (workers == 1 ? " worker:  " : " workers: ")
+												 << ofToString(time, 2) << " ms/frame, "
+												 << ofToString(mainThreadTime / time, 2) << "x";
+		if (getChecksum() != expectedChecksum)
+		{
+			ofLogError("concurrentUpdateBenchmark") << workers << " workers computed different particles";
+			failures++;
+		}
+	}
+
+	// Back to the default for the rest of the app:
+	MTThreadPool::shared().setNumThreads(0);
+	ofExit(failures == 0 ? 0 : 1);
+}
+
+double testApp::timeUpdates(int frameCount)
+{
+	for (auto& view : particleViews)
+	{
+		view->reset();
+	}
+
+	ofEventArgs args;
+	auto start = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < frameCount; frame++)
+	{
+		window->update(args);
+	}
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frameCount;
+}
+
+double testApp::getChecksum() const
+{
+	double sum = 0;
+	for (auto& view : particleViews)
+	{
+		sum += view->getChecksum();
+	}
+	return sum;
+}
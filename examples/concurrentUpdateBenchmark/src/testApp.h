@@ -0,0 +1,43 @@
+#pragma once
+
+#include "ofxMTAppFramework.h"
+#include "MTApp.hpp"
+#include "MTOffscreenWindow.hpp"
+
+/// A view whose update() integrates a few particles, standing in for the
+/// per-view computation that setConcurrentUpdate() is meant for.
+class ParticleView : public MTView{
+
+	public:
+	ParticleView(std::string name);
+
+	void update() override;
+	void reset();
+	/// A sum of the particle positions, to check that every run computed the
+	/// same thing.
+	double getChecksum() const;
+
+	private:
+	std::vector<glm::vec2> positions;
+	std::vector<glm::vec2> velocities;
+};
+
+/// Times MTWindow::update over a tree of 8 opted-in containers holding 32
+/// ParticleViews each, with the updates on the main thread and then on 1 to
+/// N pool workers, N being the number of hardware threads. Logs the time per
+/// frame and the speedup of each. Exits with 1 if a run computes different
+/// particles.
+class testApp : public MTApp{
+
+	public:
+	void appWillRun() override;
+
+	private:
+	std::shared_ptr<MTOffscreenWindow> window;
+	std::vector<std::shared_ptr<MTView>> containers;
+	std::vector<std::shared_ptr<ParticleView>> particleViews;
+
+	/// \returns the milliseconds per frame.
+	double timeUpdates(int frameCount);
+	double getChecksum() const;
+};
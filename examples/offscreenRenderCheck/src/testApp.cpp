@@ -0,0 +1,108 @@
+#include "testApp.h"
+#include "MTView.hpp"
+
+namespace
+{
+const int WindowWidth = 200;
+// Tall, so that a scissor box flipped the wrong way lands far from the right one:
+const int WindowHeight = 1000;
+}
+
+void testApp::appWillRun()
+{
+	ofGLFWWindowSettings settings;
+	settings.setSize(WindowWidth, WindowHeight);
+	window = createOffscreenWindow("Render Check", settings);
+	window->setUnthrottled(true);
+	window->backgroundColor = ofColor::white;
+
+	// The child covers (70, 70, 200, 200) in the window, but it is clipped to
+	// its superview's frame, (20, 20, 100, 100):
+	clipView = MTView::CreateView<MTView>("Clip");
+	clipView->setFrame(ofRectangle(20, 20, 100, 100));
+	clipView->backgroundColor = ofColor::black;
+	clipView->clipToFrame = true;
+
+	childView = MTView::CreateView<MTView>("Child");
+	childView->setFrame(ofRectangle(50, 50, 200, 200));
+	childView->backgroundColor = ofColor::red;
+	clipView->addSubview(childView);
+
+	moverView = MTView::CreateView<MTView>("Mover");
+	moverView->setFrame(ofRectangle(20, 2, 20, 10));
+	moverView->backgroundColor = ofColor::blue;
+
+	window->addSubview(clipView);
+	window->addSubview(moverView);
+
+	checkClipping("window");
+	clipView->setLayerBacked(true);
+	checkClipping("layer");
+	clipView->setLayerBacked(false);
+	checkPartialRedraw();
+	checkDeterminism();
+
+	if (failures == 0)
+	{
+		ofLogNotice("offscreenRenderCheck") << "All checks passed";
+	}
+	ofExit(failures == 0 ? 0 : 1);
+}
+
+void testApp::checkClipping(const std::string& label)
+{
+	window->renderFrames(1);
+	expectColor(label + ": clipped child", 100, 100, ofColor::red);
+	expectColor(label + ": clip view", 100, 40, ofColor::black);
+	expectColor(label + ": outside of the clip rect", 150, 150, ofColor::white);
+	// Where a flipped scissor box would have put the child:
+	expectColor(label + ": mirrored clip rect", 100, WindowHeight - 100, ofColor::white);
+}
+
+void testApp::checkPartialRedraw()
+{
+	window->setPartialRedrawEnabled(true);
+	window->renderFrames(1);
+	expectColor("partial redraw: mover", 25, 5, ofColor::blue);
+
+	// Only the old and new bounds of the mover are damaged:
+	moverView->setFrameOrigin(150, 2);
+	window->renderFrames(1);
+	expectColor("partial redraw: mover's old bounds", 25, 5, ofColor::white);
+	expectColor("partial redraw: mover's new bounds", 155, 5, ofColor::blue);
+	expectColor("partial redraw: mirrored damage", 155, WindowHeight - 5, ofColor::white);
+	auto partialHash = window->hashPixels();
+
+	window->setPartialRedrawEnabled(false);
+	window->renderFrames(1);
+	if (window->hashPixels() != partialHash)
+	{
+		ofLogError("offscreenRenderCheck") << "partial redraw: differs from a full redraw";
+		failures++;
+	}
+}
+
+void testApp::checkDeterminism()
+{
+	window->renderFrames(1);
+	auto hash = window->hashPixels();
+	window->renderFrames(1);
+	if (window->hashPixels() != hash)
+	{
+		ofLogError("offscreenRenderCheck") << "determinism: the same scene hashed differently";
+		failures++;
+	}
+}
+
+void testApp::expectColor(const std::string& label, int x, int y, const ofColor& expected)
+{
+	ofPixels pixels;
+	window->readPixels(pixels);
+	auto color = pixels.getColor(x, y);
+	if (color.r != expected.r || color.g != expected.g || color.b != expected.b)
+	{
+		ofLogError("offscreenRenderCheck") << label << ": expected " << expected << " at " << x << ", " << y
+										   << ", got " << color;
+		failures++;
+	}
+}
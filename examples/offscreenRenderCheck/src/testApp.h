@@ -0,0 +1,30 @@
+#pragma once
+
+#include "ofxMTAppFramework.h"
+#include "MTApp.hpp"
+#include "MTOffscreenWindow.hpp"
+
+class MTView;
+
+/// Draws a few scenes in an MTOffscreenWindow and checks the pixels that come
+/// back: a view clipped by its superview, the same inside a layer, partial
+/// redraw of a view moving along the top edge of a tall window, and that a
+/// frame hashes the same when it is drawn again. Exits with 1 if any check
+/// fails.
+class testApp : public MTApp{
+
+	public:
+	void appWillRun() override;
+
+	private:
+	std::shared_ptr<MTOffscreenWindow> window;
+	std::shared_ptr<MTView> clipView;
+	std::shared_ptr<MTView> childView;
+	std::shared_ptr<MTView> moverView;
+	int failures = 0;
+
+	void checkClipping(const std::string& label);
+	void checkPartialRedraw();
+	void checkDeterminism();
+	void expectColor(const std::string& label, int x, int y, const ofColor& expected);
+};
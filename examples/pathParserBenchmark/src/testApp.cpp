@@ -0,0 +1,272 @@
+#include "testApp.h"
+#include <chrono>
+
+namespace
+{
+/// The parser that PathFromString used before ParsePathCommands, kept here to
+/// compare against. curveTo falls through into bezierTo, as it did.
+ofPath OldPathFromString(std::string s)
+{
+	std::vector<std::string> commandStrings = ofSplitString(s, "{", true, true);
+	ofPath thePath;
+	thePath.setFilled(false);
+	for (auto cs : commandStrings)
+	{
+		std::vector<std::string> commandStringElements = ofSplitString(cs, ";", true, true);
+
+		int commandType = ofToInt(commandStringElements[0]);
+		ofPoint p, cp1, cp2;
+		switch (commandType)
+		{
+		case ofPath::Command::moveTo:
+			p = ofFromString<ofPoint>(commandStringElements[1]);
+			thePath.moveTo(p);
+			break;
+		case ofPath::Command::lineTo:
+			p = ofFromString<ofPoint>(commandStringElements[1]);
+			thePath.lineTo(p);
+			break;
+		case ofPath::Command::curveTo:
+			p = ofFromString<ofPoint>(commandStringElements[1]);
+			thePath.curveTo(p);
+			[[fallthrough]];
+		case ofPath::Command::bezierTo:
+			p = ofFromString<ofPoint>(commandStringElements[1]);
+			cp1 = ofFromString<ofPoint>(commandStringElements[2]);
+			cp2 = ofFromString<ofPoint>(commandStringElements[3]);
+			thePath.bezierTo(cp1, cp2, p);
+			break;
+		case ofPath::Command::close: thePath.close(); break;
+		default: break;
+		}
+	}
+
+	return thePath;
+}
+
+bool IsNear(const glm::vec3& a, const glm::vec3& b)
+{
+	// PathToString writes 6 significant digits:
+	for (int axis = 0; axis < 3; axis++)
+	{
+		if (std::abs(a[axis] - b[axis]) > 1e-5f * std::max(1.0f, std::abs(a[axis]))) return false;
+	}
+	return true;
+}
+
+double MillisecondsSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+}
+
+void testApp::appWillRun()
+{
+	checkRoundTrip();
+	checkTruncated();
+	checkCorrupted();
+	benchmark();
+
+	if (failures == 0)
+	{
+		ofLogNotice("pathParserBenchmark") << "All checks passed";
+	}
+	ofExit(failures == 0 ? 0 : 1);
+}
+
+ofPath testApp::makeRandomPath(size_t commandCount)
+{
+	// Two decimals, so that 6 significant digits keep every coordinate:
+	std::uniform_int_distribution<int> coordinate(-99999, 99999);
+	auto point = [&]() { return glm::vec3(coordinate(random) / 100.0f, coordinate(random) / 100.0f, 0); };
+	std::uniform_int_distribution<int> type(ofPath::Command::moveTo, ofPath::Command::quadBezierTo);
+	std::uniform_int_distribution<int> closes(0, 15);
+
+	ofPath path;
+	auto& commands = path.getCommands();
+	commands.emplace_back(ofPath::Command::moveTo, point(), glm::vec3(0, 0, 0), glm::vec3(0, 0, 0));
+	while (commands.size() < commandCount)
+	{
+		if (closes(random) == 0)
+		{
+			commands.emplace_back(ofPath::Command::close);
+			commands.back().to = commands.back().cp1 = commands.back().cp2 = glm::vec3(0, 0, 0);
+			continue;
+		}
+		commands.emplace_back(ofPath::Command::Type(type(random)), point(), point(), point());
+	}
+	return path;
+}
+
+bool testApp::expectSameCommands(const std::string& label,
+								 const std::vector<ofPath::Command>& expected,
+								 const std::vector<ofPath::Command>& actual,
+								 size_t count)
+{
+	if (actual.size() < count || expected.size() < count)
+	{
+		ofLogError("pathParserBenchmark") << label << ": expected at least " << count << " commands, got "
+										  << actual.size();
+		failures++;
+		return false;
+	}
+	for (size_t i = 0; i < count; i++)
+	{
+		auto& e = expected[i];
+		auto& a = actual[i];
+		bool isSame = e.type == a.type;
+		if (isSame && e.type != ofPath::Command::close)
+		{
+			isSame = IsNear(e.to, a.to) && IsNear(e.cp1, a.cp1) && IsNear(e.cp2, a.cp2);
+		}
+		if (!isSame)
+		{
+			ofLogError("pathParserBenchmark") << label << ": command " << i << " differs";
+			failures++;
+			return false;
+		}
+	}
+	return true;
+}
+
+void testApp::checkRoundTrip()
+{
+	for (size_t commandCount : {1, 2, 10, 100, 1000})
+	{
+		auto path = makeRandomPath(commandCount);
+		auto s = MTAppFramework::PathToString(path);
+		ofPath parsed;
+		if (!MTAppFramework::ParsePathCommands(s, parsed))
+		{
+			ofLogError("pathParserBenchmark") << "round trip: failed to parse " << commandCount << " commands";
+			failures++;
+			continue;
+		}
+		expectSameCommands("round trip", path.getCommands(), parsed.getCommands(), commandCount);
+		if (parsed.getCommands().size() != commandCount)
+		{
+			ofLogError("pathParserBenchmark") << "round trip: got " << parsed.getCommands().size() << " commands, "
+											  << "expected " << commandCount;
+			failures++;
+		}
+	}
+}
+
+void testApp::checkTruncated()
+{
+	auto path = makeRandomPath(50);
+	auto s = MTAppFramework::PathToString(path);
+
+	// Errors are expected, and there would be one for every length:
+	auto logLevel = ofGetLogLevel();
+	ofSetLogLevel(OF_LOG_SILENT);
+	for (size_t length = 0; length < s.size(); length++)
+	{
+		auto truncated = s.substr(0, length);
+		ofPath parsed;
+		MTAppFramework::ParsePathCommands(truncated, parsed);
+
+		// Every command whose closing brace survived must be intact. The
+		// command that was cut may or may not be there:
+		auto completeCount = std::count(truncated.begin(), truncated.end(), '}');
+		if (!expectSameCommands("truncated to " + ofToString(length), path.getCommands(), parsed.getCommands(),
+								completeCount))
+		{
+			break;
+		}
+	}
+	ofSetLogLevel(logLevel);
+}
+
+void testApp::checkCorrupted()
+{
+	auto path = makeRandomPath(50);
+	auto s = MTAppFramework::PathToString(path);
+	const std::string alphabet = "{};,.-+eE0123456789 \t\nxnaif";
+	std::uniform_int_distribution<size_t> position(0, s.size() - 1);
+	std::uniform_int_distribution<size_t> character(0, alphabet.size() - 1);
+	std::uniform_int_distribution<int> byte(0, 255);
+	std::uniform_int_distribution<int> edits(1, 8);
+
+	auto logLevel = ofGetLogLevel();
+	ofSetLogLevel(OF_LOG_SILENT);
+	for (int i = 0; i < 10000; i++)
+	{
+		auto corrupted = s;
+		for (int edit = edits(random); edit > 0; edit--)
+		{
+			auto p = position(random);
+			switch (edit % 4)
+			{
+			case 0: corrupted[p] = char(byte(random)); break;
+			case 1: corrupted[p] = alphabet[character(random)]; break;
+			case 2: corrupted.erase(p, 1); break;
+			default: corrupted.insert(p, 1, alphabet[character(random)]); break;
+			}
+			if (corrupted.empty()) break;
+		}
+
+		// Only the commands before the first edit must be intact:
+		size_t firstDifference = 0;
+		while (firstDifference < corrupted.size() && firstDifference < s.size() &&
+			   corrupted[firstDifference] == s[firstDifference])
+		{
+			firstDifference++;
+		}
+		auto intactCount = std::count(s.begin(), s.begin() + firstDifference, '}');
+
+		ofPath parsed;
+		MTAppFramework::ParsePathCommands(corrupted, parsed);
+		if (!expectSameCommands("corrupted", path.getCommands(), parsed.getCommands(), intactCount)) break;
+	}
+	ofSetLogLevel(logLevel);
+}
+
+void testApp::benchmark()
+{
+	const int pathCount = 200;
+	const int repetitions = 5;
+	std::vector<std::string> strings;
+	size_t totalSize = 0;
+	for (int i = 0; i < pathCount; i++)
+	{
+		auto path = makeRandomPath(1000);
+		strings.push_back(MTAppFramework::PathToString(path));
+		totalSize += strings.back().size();
+	}
+
+	// Summed, so that the parsing can't be optimized away:
+	size_t oldCommands = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (int r = 0; r < repetitions; r++)
+	{
+		for (auto& s : strings)
+		{
+			oldCommands += OldPathFromString(s).getCommands().size();
+		}
+	}
+	double oldTime = MillisecondsSince(start);
+
+	size_t newCommands = 0;
+	start = std::chrono::steady_clock::now();
+	for (int r = 0; r < repetitions; r++)
+	{
+		for (auto& s : strings)
+		{
+			newCommands += MTAppFramework::PathFromString(s).getCommands().size();
+		}
+	}
+	double newTime = MillisecondsSince(start);
+
+	double megabytes = totalSize * repetitions / (1024.0 * 1024.0);
+	ofLogNotice("pathParserBenchmark") << "Parsed " << pathCount << " paths of 1000 commands, " << repetitions
+									   << " times (" << ofToString(megabytes, 1) << " MB)";
+	ofLogNotice("pathParserBenchmark") << "ofSplitString parser: " << ofToString(oldTime, 1) << " ms, "
+									   << oldCommands << " commands";
+	ofLogNotice("pathParserBenchmark") << "ParsePathCommands:    " << ofToString(newTime, 1) << " ms, "
+									   << newCommands << " commands";
+	if (newTime > 0)
+	{
+		ofLogNotice("pathParserBenchmark") << "Speedup: " << ofToString(oldTime / newTime, 1) << "x";
+	}
+}
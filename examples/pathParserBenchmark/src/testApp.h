@@ -0,0 +1,31 @@
+#pragma once
+
+#include "ofxMTAppFramework.h"
+#include "MTApp.hpp"
+#include <random>
+
+/// Checks MTAppFramework::ParsePathCommands against PathToString: random paths
+/// must come back unchanged, and truncated or corrupted strings must parse
+/// without crashing, keeping the commands before the damage. Then times it
+/// against the ofSplitString based parser it replaced. Build it with
+/// -fsanitize=address,undefined to fuzz the parser. Exits with 1 if any check
+/// fails.
+class testApp : public MTApp{
+
+	public:
+	void appWillRun() override;
+
+	private:
+	std::mt19937 random{1234};
+	int failures = 0;
+
+	ofPath makeRandomPath(size_t commandCount);
+	void checkRoundTrip();
+	void checkTruncated();
+	void checkCorrupted();
+	void benchmark();
+	bool expectSameCommands(const std::string& label,
+							const std::vector<ofPath::Command>& expected,
+							const std::vector<ofPath::Command>& actual,
+							size_t count);
+};
@@ -0,0 +1,123 @@
+#include "testApp.h"
+#include "MTView.hpp"
+#include <chrono>
+
+namespace
+{
+const int WindowSize = 1000;
+// A grid of containers, each holding a grid of leaves:
+const int ContainersPerSide = 10;
+const int LeavesPerSide = 10;
+const int FrameCount = 200;
+}
+
+void testApp::appWillRun()
+{
+	ofGLFWWindowSettings settings;
+	settings.setSize(WindowSize, WindowSize);
+	window = createOffscreenWindow("Render List Benchmark", settings);
+	window->setUnthrottled(true);
+	window->backgroundColor = ofColor::white;
+	buildTree();
+
+	compare("static", nullptr);
+	compare("moving container",
+			[this](int frame)
+			{
+				auto& container = containers[frame / 2 % containers.size()];
+				auto origin = container->getFrameOrigin();
+				container->setFrameOrigin(origin.x + (frame % 2 == 0 ? 1 : -1), origin.y);
+			});
+	compare("added and removed view",
+			[this](int frame)
+			{
+				auto& container = containers[frame / 2 % containers.size()];
+				if (frame % 2 == 0)
+				{
+					container->addSubview(extraView);
+				}
+				else
+				{
+					extraView->removeFromSuperview();
+				}
+			});
+
+	if (failures == 0)
+	{
+		ofLogNotice("renderListBenchmark") << "Both traversals drew the same pixels";
+	}
+	ofExit(failures == 0 ? 0 : 1);
+}
+
+void testApp::buildTree()
+{
+	float containerSize = float(WindowSize) / ContainersPerSide;
+	// Leaves overhang their container by half a leaf, so that clipping shows:
+	float leafSize = containerSize / (LeavesPerSide - 0.5f);
+	for (int cy = 0; cy < ContainersPerSide; cy++)
+	{
+		for (int cx = 0; cx < ContainersPerSide; cx++)
+		{
+			auto name = "Container " + ofToString(containers.size());
+			auto container = MTView::CreateView<MTView>(name);
+			container->setFrame(ofRectangle(cx * containerSize, cy * containerSize, containerSize, containerSize));
+			container->backgroundColor = ofColor::lightGray;
+			container->clipToFrame = (cx + cy) % 2 == 0;
+
+			for (int ly = 0; ly < LeavesPerSide; ly++)
+			{
+				for (int lx = 0; lx < LeavesPerSide; lx++)
+				{
+					auto leaf = MTView::CreateView<MTView>("Leaf");
+					leaf->setFrame(ofRectangle(lx * leafSize, ly * leafSize, leafSize * 0.75f, leafSize * 0.75f));
+					leaf->backgroundColor = ofColor::fromHsb((lx * LeavesPerSide + ly) * 2 % 255, 200, 220);
+					container->addSubview(leaf);
+				}
+			}
+			window->addSubview(container);
+			containers.push_back(container);
+		}
+	}
+
+	extraView = MTView::CreateView<MTView>("Extra");
+	extraView->setFrame(ofRectangle(10, 10, 30, 30));
+	extraView->backgroundColor = ofColor::black;
+}
+
+double testApp::timeFrames(int frameCount, const std::function<void(int)>& change)
+{
+	// Settle the matrices and the render list, and the GL pipeline:
+	window->renderFrames(1);
+	glFinish();
+
+	auto start = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < frameCount; frame++)
+	{
+		if (change) change(frame);
+		window->renderFrames(1);
+	}
+	glFinish();
+	auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return elapsed / frameCount;
+}
+
+void testApp::compare(const std::string& scene, const std::function<void(int)>& change)
+{
+	// Odd frames undo the change of the frame before, so after an even number
+	// of frames both traversals draw the same tree:
+	window->setRenderListEnabled(false);
+	double recursiveTime = timeFrames(FrameCount, change);
+	auto recursiveHash = window->hashPixels();
+
+	window->setRenderListEnabled(true);
+	double renderListTime = timeFrames(FrameCount, change);
+	auto renderListHash = window->hashPixels();
+
+	ofLogNotice("renderListBenchmark") << scene << ": recursive " << ofToString(recursiveTime, 3)
+									   << " ms/frame, render list " << ofToString(renderListTime, 3) << " ms/frame";
+	if (recursiveHash != renderListHash)
+	{
+		ofLogError("renderListBenchmark") << scene << ": the render list drew different pixels";
+		failures++;
+	}
+}
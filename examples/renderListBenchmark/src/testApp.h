@@ -0,0 +1,30 @@
+#pragma once
+
+#include "ofxMTAppFramework.h"
+#include "MTApp.hpp"
+#include "MTOffscreenWindow.hpp"
+
+class MTView;
+
+/// Draws a tree of 10,100 views in an MTOffscreenWindow, once with the
+/// recursive traversal and once with the window's flat render list, and logs
+/// the time per frame of each: with a static tree, with a container moving
+/// every frame, and with a view added and removed every frame. Exits with 1
+/// if the two traversals draw different pixels.
+class testApp : public MTApp{
+
+	public:
+	void appWillRun() override;
+
+	private:
+	std::shared_ptr<MTOffscreenWindow> window;
+	std::vector<std::shared_ptr<MTView>> containers;
+	std::shared_ptr<MTView> extraView;
+	int failures = 0;
+
+	void buildTree();
+	/// Draws `frameCount` frames, calling `change` before each one.
+	/// \returns the milliseconds per frame.
+	double timeFrames(int frameCount, const std::function<void(int)>& change);
+	void compare(const std::string& scene, const std::function<void(int)>& change);
+};
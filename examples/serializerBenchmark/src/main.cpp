@@ -0,0 +1,7 @@
+#include "ofxMTAppFramework.h"
+#include "testApp.h"
+
+//========================================================================
+int main( ){
+	MTApp::CreateApp<testApp, BenchmarkModel>();
+}
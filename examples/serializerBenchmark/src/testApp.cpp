@@ -0,0 +1,261 @@
+#include "testApp.h"
+#include "MTBinarySerializer.hpp"
+#include "MTStreamingReader.hpp"
+#include <chrono>
+#include <random>
+
+namespace
+{
+const int GroupCount = 200;
+const int ValuesPerGroup = 1000;
+const int PathCount = 600;
+const int CommandsPerPath = 4500;
+
+double MillisecondsSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+}
+
+void BenchmarkModel::build()
+{
+	std::mt19937 random(1234);
+	std::uniform_int_distribution<int> coordinate(-7999, 7999);
+	std::uniform_int_distribution<int> unit(0, 8);
+	auto number = [&]() { return coordinate(random) / 8.0f; };
+	auto point = [&]() { return glm::vec3(number(), number(), 0); };
+
+	ofParameterGroup values;
+	values.setName("Values");
+	for (int g = 0; g < GroupCount; g++)
+	{
+		ofParameterGroup group;
+		group.setName("Group" + ofToString(g));
+		for (int v = 0; v < ValuesPerGroup; v++)
+		{
+			auto name = "Value" + ofToString(v);
+			switch (v % 5)
+			{
+			case 0: group.add(ofParameter<float>().set(name, number())); break;
+			case 1: group.add(ofParameter<int>().set(name, coordinate(random))); break;
+			case 2: group.add(ofParameter<bool>().set(name, coordinate(random) > 0)); break;
+			case 3: group.add(ofParameter<glm::vec3>().set(name, glm::vec3(number(), number(), number()))); break;
+			default:
+				group.add(ofParameter<ofFloatColor>().set(
+					name, ofFloatColor(unit(random) / 8.0f, unit(random) / 8.0f, unit(random) / 8.0f, 1)));
+				break;
+			}
+		}
+		values.add(group);
+	}
+	parameters.add(values);
+
+	ofParameterGroup paths;
+	paths.setName("Paths");
+	for (int p = 0; p < PathCount; p++)
+	{
+		ofPath path;
+		path.moveTo(point());
+		for (int c = 1; c < CommandsPerPath; c++)
+		{
+			if (c % 2 == 0)
+			{
+				path.lineTo(point());
+			}
+			else
+			{
+				path.bezierTo(point(), point(), point());
+			}
+		}
+		paths.add(ofParameter<ofPath>().set("Path" + ofToString(p), path));
+	}
+	parameters.add(paths);
+}
+
+void BenchmarkModel::clear()
+{
+	clear(parameters);
+}
+
+void BenchmarkModel::clear(ofParameterGroup& group)
+{
+	for (auto& parameter : group)
+	{
+		if (auto p = std::dynamic_pointer_cast<ofParameterGroup>(parameter))
+		{
+			clear(*p);
+		}
+		else if (auto p = std::dynamic_pointer_cast<ofParameter<float>>(parameter))
+		{
+			p->set(0);
+		}
+		else if (auto p = std::dynamic_pointer_cast<ofParameter<int>>(parameter))
+		{
+			p->set(0);
+		}
+		else if (auto p = std::dynamic_pointer_cast<ofParameter<bool>>(parameter))
+		{
+			p->set(false);
+		}
+		else if (auto p = std::dynamic_pointer_cast<ofParameter<glm::vec3>>(parameter))
+		{
+			p->set(glm::vec3(0, 0, 0));
+		}
+		else if (auto p = std::dynamic_pointer_cast<ofParameter<ofFloatColor>>(parameter))
+		{
+			p->set(ofFloatColor(0, 0, 0, 0));
+		}
+		else if (auto p = std::dynamic_pointer_cast<ofParameter<ofPath>>(parameter))
+		{
+			p->set(ofPath());
+		}
+	}
+}
+
+std::string BenchmarkModel::fingerprint()
+{
+	MTBinaryWriter writer;
+	serialize(writer);
+	return writer.toString();
+}
+
+void testApp::appWillRun()
+{
+	auto benchmarkModel = MTApp::GetModel<BenchmarkModel>();
+	auto start = std::chrono::steady_clock::now();
+	benchmarkModel->build();
+	ofLogNotice("serializerBenchmark") << "Built the model in " << ofToString(MillisecondsSince(start), 0) << " ms";
+
+	run(
+		"Binary",
+		"benchmark.mtb",
+		[&](const std::filesystem::path& path)
+		{
+			MTBinaryWriter serializer;
+			benchmarkModel->serialize(serializer);
+			return serializer.save(path);
+		},
+		[&](const std::filesystem::path& path)
+		{
+			MTBinaryReader serializer;
+			if (!serializer.open(path)) return false;
+			benchmarkModel->deserialize(serializer);
+			return true;
+		});
+
+	run(
+		"XML",
+		"benchmark.xml",
+		[&](const std::filesystem::path& path)
+		{
+			ofXml serializer;
+			benchmarkModel->serialize(serializer);
+			return MTAppFramework::WriteFileAtomically(path, serializer.toString());
+		},
+		[&](const std::filesystem::path& path)
+		{
+			ofXml serializer;
+			if (!serializer.load(path)) return false;
+			benchmarkModel->deserialize(serializer);
+			return true;
+		});
+
+	run(
+		"XML (streaming)",
+		"benchmark.xml",
+		nullptr,
+		[&](const std::filesystem::path& path)
+		{
+			MTStreamingReader reader;
+			if (!reader.open(path, MTStreamingReader::FormatXML)) return false;
+			benchmarkModel->deserialize(reader);
+			return reader.getError().empty();
+		});
+
+	run(
+		"JSON",
+		"benchmark.json",
+		[&](const std::filesystem::path& path)
+		{
+			ofJson serializer;
+			benchmarkModel->serialize(serializer);
+			return MTAppFramework::WriteFileAtomically(path, serializer.dump(4));
+		},
+		[&](const std::filesystem::path& path)
+		{
+			ofJson serializer = ofLoadJson(path);
+			if (serializer.empty()) return false;
+			benchmarkModel->deserialize(serializer);
+			return true;
+		});
+
+	run(
+		"JSON (streaming)",
+		"benchmark.json",
+		nullptr,
+		[&](const std::filesystem::path& path)
+		{
+			MTStreamingReader reader;
+			if (!reader.open(path, MTStreamingReader::FormatJSON)) return false;
+			benchmarkModel->deserialize(reader);
+			return reader.getError().empty();
+		});
+
+	for (auto fileName : {"benchmark.mtb", "benchmark.xml", "benchmark.json"})
+	{
+		std::error_code error;
+		std::filesystem::remove(ofToDataPath(fileName, true), error);
+	}
+
+	if (failures == 0)
+	{
+		ofLogNotice("serializerBenchmark") << "Every format loaded back what was saved";
+	}
+	ofExit(failures == 0 ? 0 : 1);
+}
+
+/// Saves the model with `save`, unless it is null because an earlier run
+/// wrote the file, clears it, then loads it back with `load`.
+void testApp::run(const std::string& format,
+				  const std::string& fileName,
+				  const std::function<bool(const std::filesystem::path&)>& save,
+				  const std::function<bool(const std::filesystem::path&)>& load)
+{
+	auto benchmarkModel = MTApp::GetModel<BenchmarkModel>();
+	std::filesystem::path path = ofToDataPath(fileName, true);
+	auto expected = benchmarkModel->fingerprint();
+
+	std::string saveTime = "-";
+	if (save)
+	{
+		auto start = std::chrono::steady_clock::now();
+		if (!save(path))
+		{
+			ofLogError("serializerBenchmark") << format << ": could not save " << path;
+			failures++;
+			return;
+		}
+		saveTime = ofToString(MillisecondsSince(start), 0) + " ms";
+	}
+
+	benchmarkModel->clear();
+	auto start = std::chrono::steady_clock::now();
+	bool isLoaded = load(path);
+	double loadTime = MillisecondsSince(start);
+
+	if (!isLoaded)
+	{
+		ofLogError("serializerBenchmark") << format << ": could not load " << path;
+		failures++;
+	}
+	else if (benchmarkModel->fingerprint() != expected)
+	{
+		ofLogError("serializerBenchmark") << format << ": the loaded model differs from the saved one";
+		failures++;
+	}
+
+	std::error_code error;
+	auto size = std::filesystem::file_size(path, error);
+	ofLogNotice("serializerBenchmark") << format << ": " << ofToString(size / (1024.0 * 1024.0), 1) << " MB, save "
+									   << saveTime << ", load " << ofToString(loadTime, 0) << " ms";
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "ofxMTAppFramework.h"
+#include "MTApp.hpp"
+
+/// A model with about 100 MB of parameters when written as XML: 200 groups
+/// of 1000 numbers, vectors and colors, and 600 paths of 4500 commands.
+/// Values are multiples of 1/8, so that the text formats keep them exactly.
+class BenchmarkModel : public MTModel{
+
+	public:
+	BenchmarkModel(std::string name) : MTModel(name) {}
+
+	void build();
+	/// Sets every parameter back to zero, or to an empty path.
+	void clear();
+	/// The model as a binary document, to compare what was loaded against
+	/// what was saved.
+	std::string fingerprint();
+
+	private:
+	void clear(ofParameterGroup& group);
+};
+
+/// Saves and loads BenchmarkModel as MTApp does with each serializer type,
+/// binary, XML and JSON, plus the streaming reader for the text formats, and
+/// logs the times and file sizes. Exits with 1 if a format doesn't load back
+/// what was saved.
+class testApp : public MTApp{
+
+	public:
+	void appWillRun() override;
+
+	private:
+	int failures = 0;
+
+	void run(const std::string& format,
+			 const std::string& fileName,
+			 const std::function<bool(const std::filesystem::path&)>& save,
+			 const std::function<bool(const std::filesystem::path&)>& load);
+};
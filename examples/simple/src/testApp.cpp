@@ -38,7 +38,7 @@ void testApp::createAppViews()
 //	offscreenView = std::make_shared<MTOffscreenView>("offscreen view");
 //	offscreenView->setSize(300, 300);
 //
-//	offscreenView->onDraw = [this]()
+//	offscreenView->callbacks().onDraw = [this]()
 //	{
 //		ofClear(0, 0);
 //		ofSetColor(127);
@@ -47,7 +47,7 @@ void testApp::createAppViews()
 //	};
 
 
-	view1->onMouseMoved = [](MTView* view, int x, int y) {
+	view1->callbacks().onMouseMoved = [](MTView* view, int x, int y) {
 		auto coord = glm::vec2(x, y);
 		auto tcoord = view->transformFramePointToContent(coord);
 //		ofLogVerbose() << view->name << " Pased: " << coord <<
@@ -55,7 +55,7 @@ void testApp::createAppViews()
 //						  " To Content: " << tcoord;
 	};
 
-	view1->onDraw = [](MTView* view) {
+	view1->callbacks().onDraw = [](MTView* view) {
 //		offscreenView->drawOffscreen();
 		ofSetColor(255);
 //		offscreenView->getViewTexture().draw(0, 0);
@@ -67,30 +67,30 @@ void testApp::createAppViews()
 
 	};
 
-	view1->onMousePressed = [](MTView* view, int x, int y, int b) {
+	view1->callbacks().onMousePressed = [](MTView* view, int x, int y, int b) {
 		ofLogVerbose() << view->name << " " << view->getContentMouse();
 		//        mainWindow->contentView->removeSubview(view1);
 		//		view1->removeFromSuperview();
 
 	};
 
-	view1->onMouseDragged = [this](MTView* view, int x, int y, int b) {
+	view1->callbacks().onMouseDragged = [this](MTView* view, int x, int y, int b) {
 		dragView(view, x, y);
 	};
 
-	view2->onMouseDragged = [this](MTView* view, int x, int y, int b) {
+	view2->callbacks().onMouseDragged = [this](MTView* view, int x, int y, int b) {
 		dragView(view, x, y);
 	};
 
-	view1_2->onMouseDragged = [this](MTView* view, int x, int y, int b) {
+	view1_2->callbacks().onMouseDragged = [this](MTView* view, int x, int y, int b) {
 		dragView(view, x, y);
 	};
 
-	view1_2->onMousePressed = [](MTView* view, int x, int y, int b) {
+	view1_2->callbacks().onMousePressed = [](MTView* view, int x, int y, int b) {
 		ofLogVerbose() << view->name << " " << view->getContentMouse();
 	};
 
-	view2->onMousePressed = [](MTView* view, int x, int y, int b) {
+	view2->callbacks().onMousePressed = [](MTView* view, int x, int y, int b) {
 		ofLogVerbose() << view->name << " " << view->getContentMouse();
 	};
 
@@ -103,7 +103,7 @@ void testApp::createAppViews()
 
 	mainWindow->backgroundColor = ofColor::white;
 
-//	mainWindow->contentView->onMousePressed = [this](MTView* view, int x, int y, int b) {
+//	mainWindow->contentView->callbacks().onMousePressed = [this](MTView* view, int x, int y, int b) {
 //		ofLogVerbose() << getMainWindow().lock()->contentView->name;
 //	};
 
@@ -19,11 +19,15 @@
 #include "ofWindowSettings.h"
 #include "ofSystemUtils.h"
 #include "ofPath.h"
+#include <chrono>
+#include <cstring>
+#include <fstream>
 #include "MTApp.hpp"
 
 #ifndef TARGET_RASPBERRY_PI
 
 #include "MTWindow.hpp"
+#include "MTOffscreenWindow.hpp"
 #include "MTModel.hpp"
 
 #endif
@@ -67,6 +71,8 @@ MTApp::MTApp()
     internalEventListeners.push(ofGetMainLoop()->loopEvent.newListener(
         [this]()
         {
+            fileOperationQueue.drain();
+
             // We only iterate until size so that if a
             // loopFunction adds another entry into the deque
             // it won't get executed until the next loop
@@ -81,6 +87,12 @@ MTApp::MTApp()
             }
         }));
 
+    appPreferencesWriteListener = ofGetMainLoop()->loopEvent.newListener(
+        [this]()
+        {
+            writePendingAppPreferences();
+        });
+
     internalEventListeners.push(ofGetMainLoop()->exitEvent.newListener(
         [this]()
         {
@@ -159,11 +171,13 @@ MTApp::~MTApp()
      }
     exit();
     saveAppPreferences();
+    flushAppPreferences();
     releasePointers();
 }
 
 void MTApp::loadAppPreferences()
 {
+    MT_PROFILE_SCOPE("MTApp::loadAppPreferences");
     ofXml appPrefsXml;
     if (!appPrefsXml.load(appPreferencesPath))
     {
@@ -258,6 +272,7 @@ void MTApp::exit(ofEventArgs& args)
     }
 
     saveAppPreferences();
+    flushAppPreferences();
 
     eventListeners.unsubscribeAll();
 }
@@ -315,63 +330,60 @@ MTAppModeName MTApp::getAppMode()
 
 #ifndef TARGET_RASPBERRY_PI
 
-// std::shared_ptr<MTOffscreenWindow>
-// MTApp::createOffscreenWindow(std::string windowName, ofGLFWWindowSettings&
-// settings, bool useTextureRectangle)
-//{
-//	if (ofGetTargetPlatform() == OF_TARGET_ANDROID ||
-//		ofGetTargetPlatform() == OF_TARGET_IOS ||
-//		ofGetTargetPlatform() == OF_TARGET_LINUXARMV6L ||
-//		ofGetTargetPlatform() == OF_TARGET_LINUXARMV7L ||
-//		ofGetTargetPlatform() == OF_TARGET_EMSCRIPTEN)
-//	{
-//		ofLogError("MTApp") << "createOffscreenWindow() is not
-//compatible with the current platform"; 		return nullptr;
-//	}
-//
-//	if (!ofAppInitialized)
-//	{
-//		glVersionMajor = settings.glVersionMajor;
-//		glVersionMinor = settings.glVersionMinor;
-//	}
-//	else
-//	{
-//		settings.glVersionMajor = glVersionMajor;
-//		settings.glVersionMinor = glVersionMinor;
-//	}
-//
-//	auto offscreenWindow = std::make_shared<MTOffscreenWindow>(windowName,
-//useTextureRectangle);
-////	ofGLFWWindowSettings* glfwWS =
-///dynamic_cast<ofGLFWWindowSettings*>(&settings);
-//	offscreenWindow->setup(settings);
-//	addAllEvents(offscreenWindow.get());
-//	ofGetMainLoop()->addWindow(offscreenWindow);
-//	windows.push_back(offscreenWindow);
-//
-//	glfwHideWindow(offscreenWindow->getGLFWWindow());
-//
-//	// The ofApp system only notifies setup for the first window it creates,
-//	// the rest are on their own apparently. So we check if we have
-//initialized
-//	// the ofApp system, and if we have, then
-//	// that means that we need to notify setup for the window we are
-//creating
-//
-//	if (!ofAppInitialized)
-//	{
-//		ofAppInitialized = true;
-//	}
-//	else
-//	{
-//		// Note that MTView::setup is not called from this event, only
-//the
-//		// MTWindow's setup
-//		offscreenWindow->events().notifySetup();
-//	}
-//
-//	return offscreenWindow;
-//}
+std::shared_ptr<MTOffscreenWindow>
+MTApp::createOffscreenWindow(std::string windowName,
+                             ofGLFWWindowSettings settings)
+{
+    for (auto w : windows)
+    {
+        if (w->name.get() == windowName)
+        {
+            return nullptr;
+        }
+    }
+
+    if (!ofAppInitialized)
+    {
+        glVersionMajor = settings.glVersionMajor;
+        glVersionMinor = settings.glVersionMinor;
+    }
+    else
+    {
+        settings.glVersionMajor = glVersionMajor;
+        settings.glVersionMinor = glVersionMinor;
+        if (!settings.shareContextWith)
+        {
+            settings.shareContextWith = mainWindow;
+        }
+    }
+
+    auto offscreenWindow = std::make_shared<MTOffscreenWindow>(windowName);
+    ofGetMainLoop()->addWindow(offscreenWindow);
+    windows.push_back(offscreenWindow);
+    offscreenWindow->setup(settings);
+    addAllEvents(offscreenWindow.get());
+
+    // Offscreen windows are not in the window preferences, their size is
+    // whatever the settings say.
+
+    // The ofApp system only notifies setup for the first window it creates,
+    // the rest are on their own apparently. So we check if we have initialized
+    // the ofApp system, and if we have, then
+    // that means that we need to notify setup for the window we are creating
+
+    if (!ofAppInitialized)
+    {
+        ofAppInitialized = true;
+    }
+    else
+    {
+        // Note that MTView::setup is not called from this event, only the
+        // MTWindow's setup
+        offscreenWindow->events().notifySetup();
+    }
+
+    return offscreenWindow;
+}
 
 #endif
 
@@ -531,24 +543,23 @@ std::shared_ptr<MTWindow> MTApp::createWindow(std::string windowName,
 void MTApp::closeWindow(std::shared_ptr<MTWindow> window)
 {
 #ifndef TARGET_RASPBERRY_PI
-//	auto offscreenWindow =
-//std::dynamic_pointer_cast<MTOffscreenWindow>(window);
+    auto offscreenWindow = std::dynamic_pointer_cast<MTOffscreenWindow>(window);
 #else
     std::shared_ptr<MTWindow> offscreenWindow = nullptr;
 #endif
     // 	Update the Window Parameters Map if the window is not an offscreen
     // 	window
-    //	if (!offscreenWindow)
-    //	{
-    auto it = wpMap.find(window->name.get());
-    if (it != wpMap.end())
+    if (!offscreenWindow)
     {
-        auto& wp = it->second;
-        wp.position = window->getWindowPosition();
-        wp.size = window->getWindowSize();
-        saveAppPreferences();
+        auto it = wpMap.find(window->name.get());
+        if (it != wpMap.end())
+        {
+            auto& wp = it->second;
+            wp.position = window->getWindowPosition();
+            wp.size = window->getWindowSize();
+            saveAppPreferences();
+        }
     }
-    //	}
 
     auto wIter = std::find(windows.begin(), windows.end(), window);
     if (wIter != windows.end())
@@ -790,10 +801,42 @@ void MTApp::saveCopy(std::string filepath)
 {
     std::string temp = MTPrefLastFile.get();
     MTPrefLastFile.setWithoutEventNotifications(filepath);
+    isSavingCopy = true;
     saveImpl();
+    isSavingCopy = false;
     MTPrefLastFile.setWithoutEventNotifications(temp);
 }
 
+namespace
+{
+/// 32 bit FNV-1a, enough to tell a document from the one it replaced.
+uint32_t HashDocument(const char* data, size_t size, uint32_t hash = 2166136261u)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        hash = (hash ^ uint8_t(data[i])) * 16777619u;
+    }
+    return hash;
+}
+
+uint32_t HashDocument(const std::string& contents)
+{
+    return HashDocument(contents.data(), contents.size());
+}
+
+uint32_t HashDocumentFile(const std::string& path)
+{
+    std::ifstream is(path, std::ios::binary);
+    std::vector<char> buffer(1 << 16);
+    uint32_t hash = 2166136261u;
+    while (is.read(buffer.data(), buffer.size()) || is.gcount() > 0)
+    {
+        hash = HashDocument(buffer.data(), is.gcount(), hash);
+    }
+    return hash;
+}
+}
+
 bool MTApp::saveAsImpl(std::string filePath)
 {
     ofLogVerbose("MTApp") << "Saving as: " << filePath;
@@ -815,45 +858,317 @@ bool MTApp::saveAsImpl(std::string filePath)
 
 bool MTApp::saveImpl()
 {
+    MT_PROFILE_SCOPE("MTApp::save");
     ofLogVerbose("MTApp") << "Saving file";
 
+    auto dataPath = ofToDataPath(MTPrefLastFile.get(), true);
+    if (canAppendToJournal(dataPath))
+    {
+        return appendToJournal(dataPath);
+    }
+
+    if (asyncFileOperations)
+    {
+        return saveAsync();
+    }
+
     modelWillSaveEvent.notify();
 
+    bool success = true;
+    // Kept to tag the journal entries that will be relative to it:
+    std::string contents;
     if (serializerType == XML)
     {
         auto serializer = ofXml();
         model->serialize(serializer);
+        beginFullSave(dataPath, isSavingCopy);
 
-        if (!serializer.save(MTPrefLastFile.get()))
+        contents = serializer.toString();
+        if (!MTAppFramework::WriteFileAtomically(dataPath, contents))
         {
             ofLogError("MTApp")
                 << "Encountered an error while saving the XML file";
             // ofSystemAlertDialog("Encountered an error while saving the
             // file");
-            return false;
+            success = false;
         }
     }
-    else
+    else if (serializerType == JSON)
     {
         ofJson serializer;
         model->serialize(serializer);
+        beginFullSave(dataPath, isSavingCopy);
 
-        if (!ofSavePrettyJson(MTPrefLastFile.get(), serializer))
+        contents = serializer.dump(4);
+        if (!MTAppFramework::WriteFileAtomically(dataPath, contents))
         {
             ofLogError("MTApp")
                 << "Encountered an error while saving the JSON file";
             // ofSystemAlertDialog("Encountered an error while saving the
             // file");
-            return false;
+            success = false;
+        }
+    }
+    else
+    {
+        MTBinaryWriter serializer;
+        model->serialize(serializer);
+        beginFullSave(dataPath, isSavingCopy);
+
+        contents = serializer.toString();
+        if (!MTAppFramework::WriteFileAtomically(dataPath, contents))
+        {
+            ofLogError("MTApp")
+                << "Encountered an error while saving the binary file";
+            success = false;
         }
     }
+    finishFullSave(dataPath, isSavingCopy, success, HashDocument(contents));
+    if (!success)
+    {
+        return false;
+    }
+    saveAppPreferences();
+    return true;
+}
+
+#pragma mark Journal
+
+namespace
+{
+const char JournalEntryMagic[4] = {'M', 'T', 'J', 'E'};
+// Magic, u32 hash of the document the entry applies to, u64 size of the
+// entry's document, all little-endian:
+const size_t JournalEntryHeaderSize = 16;
+
+void PutLittleEndian(char* out, uint64_t value, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        out[i] = char(value >> (8 * i));
+    }
+}
+
+uint64_t GetLittleEndian(const char* in, size_t size)
+{
+    uint64_t value = 0;
+    for (size_t i = 0; i < size; i++)
+    {
+        value |= uint64_t(uint8_t(in[i])) << (8 * i);
+    }
+    return value;
+}
+
+std::string journalPath(const std::string& dataPath)
+{
+    return dataPath + ".journal";
+}
+
+/// The journal of a full save that hasn't finished yet.
+std::string compactingJournalPath(const std::string& dataPath)
+{
+    return dataPath + ".journal.compacting";
+}
+}
+
+bool MTApp::canAppendToJournal(const std::string& dataPath)
+{
+    if (!journaledSaves || isSavingCopy || dataPath != journalBasePath ||
+        model->getNeedsFullSave() || fileOperationInProgress)
+    {
+        return false;
+    }
+
+    std::error_code error;
+    if (!std::filesystem::exists(dataPath, error))
+    {
+        return false;
+    }
+    if (!isJournalBaseHashed)
+    {
+        // Opened while journaled saves were off:
+        journalBaseHash = HashDocumentFile(dataPath);
+        isJournalBaseHashed = true;
+    }
+    auto size = std::filesystem::file_size(journalPath(dataPath), error);
+    return error || size < journalCompactionSize;
+}
+
+bool MTApp::appendToJournal(const std::string& dataPath)
+{
+    MT_PROFILE_SCOPE("MTApp::appendToJournal");
+    modelWillSaveEvent.notify();
+
+    MTBinaryWriter changes;
+    model->serializeChanges(changes);
+    if (changes.getNumEntries() == 0)
+    {
+        return true;
+    }
+
+    auto entry = changes.toString();
+    char header[JournalEntryHeaderSize] = {};
+    std::memcpy(header, JournalEntryMagic, 4);
+    PutLittleEndian(header + 4, journalBaseHash, 4);
+    PutLittleEndian(header + 8, entry.size(), 8);
+
+    auto path = journalPath(dataPath);
+    std::error_code error;
+    auto previousSize = std::filesystem::file_size(path, error);
+    if (error)
+    {
+        previousSize = 0;
+    }
+
+    std::ofstream os(path, std::ios::binary | std::ios::app);
+    os.write(header, JournalEntryHeaderSize);
+    os.write(entry.data(), entry.size());
+    os.flush();
+    if (!os)
+    {
+        ofLogError("MTApp") << "Encountered an error while writing to the "
+                            << "journal of " << MTPrefLastFile.get();
+        // Entries appended after a partial one would never be replayed. Cut
+        // it off, and in case that fails too, compact on the next save:
+        os.close();
+        std::filesystem::resize_file(path, previousSize, error);
+        model->setNeedsFullSave();
+        return false;
+    }
+
+    model->markSaved();
     saveAppPreferences();
     return true;
 }
 
+/// Applies the journal entries of the document, oldest first. A truncated
+/// last entry, left by a save that was interrupted, is skipped. So are the
+/// entries of an older document, left by a full save that replaced the
+/// document but didn't get to remove the old journal.
+void MTApp::replayJournal(const std::string& dataPath)
+{
+    journalBasePath = dataPath;
+    isJournalBaseHashed = false;
+    std::error_code error;
+    auto compacting = compactingJournalPath(dataPath);
+    auto journal = journalPath(dataPath);
+    if (!journaledSaves && !std::filesystem::exists(compacting, error) &&
+        !std::filesystem::exists(journal, error))
+    {
+        return;
+    }
+
+    MT_PROFILE_SCOPE("MTApp::replayJournal");
+    journalBaseHash = HashDocumentFile(dataPath);
+    isJournalBaseHashed = true;
+    for (const auto& path : {compacting, journal})
+    {
+        std::ifstream is(path, std::ios::binary | std::ios::ate);
+        if (!is)
+        {
+            continue;
+        }
+        uint64_t remaining = is.tellg();
+        is.seekg(0);
+
+        while (remaining >= JournalEntryHeaderSize)
+        {
+            char header[JournalEntryHeaderSize];
+            is.read(header, JournalEntryHeaderSize);
+            remaining -= JournalEntryHeaderSize;
+            auto size = GetLittleEndian(header + 8, 8);
+            if (std::memcmp(header, JournalEntryMagic, 4) != 0 ||
+                size > remaining)
+            {
+                break;
+            }
+
+            std::string entry(size, '\0');
+            is.read(&entry[0], size);
+            remaining -= size;
+            if (GetLittleEndian(header + 4, 4) != journalBaseHash)
+            {
+                continue;
+            }
+            MTBinaryReader reader;
+            if (!is || !reader.parse(std::move(entry)))
+            {
+                break;
+            }
+            model->deserialize(reader);
+        }
+
+        if (remaining > 0)
+        {
+            ofLogWarning("MTApp") << "Ignored the damaged end of " << path;
+        }
+    }
+}
+
+/// Called right before a full save writes the document. Journal entries
+/// appended from now on belong to the new document, so the current journal
+/// is moved aside until the new document is safely written.
+void MTApp::beginFullSave(const std::string& dataPath, bool isCopy)
+{
+    if (isCopy)
+    {
+        return;
+    }
+    model->markSaved();
+
+    std::error_code error;
+    auto journal = journalPath(dataPath);
+    auto compacting = compactingJournalPath(dataPath);
+    if (!std::filesystem::exists(journal, error))
+    {
+        return;
+    }
+    if (!std::filesystem::exists(compacting, error))
+    {
+        std::filesystem::rename(journal, compacting, error);
+        return;
+    }
+
+    // A previous full save didn't finish, its entries are still needed:
+    {
+        std::ifstream is(journal, std::ios::binary);
+        std::ofstream os(compacting, std::ios::binary | std::ios::app);
+        os << is.rdbuf();
+    }
+    std::filesystem::remove(journal, error);
+}
+
+void MTApp::finishFullSave(const std::string& dataPath,
+                           bool isCopy,
+                           bool success,
+                           uint32_t documentHash)
+{
+    if (!success)
+    {
+        if (!isCopy)
+        {
+            model->setNeedsFullSave();
+        }
+        return;
+    }
+
+    std::error_code error;
+    std::filesystem::remove(compactingJournalPath(dataPath), error);
+    if (isCopy)
+    {
+        // Whatever journal was there belongs to an older document:
+        std::filesystem::remove(journalPath(dataPath), error);
+        return;
+    }
+    journalBasePath = dataPath;
+    journalBaseHash = documentHash;
+    isJournalBaseHashed = true;
+}
+
 /// Open sesame.
 bool MTApp::openImpl(std::string path)
 {
+    MT_PROFILE_SCOPE("MTApp::open");
     if (path.empty())
     {
         newFile();
@@ -887,15 +1202,34 @@ bool MTApp::openImpl(std::string path)
 #endif
     }
 
+    if (asyncFileOperations)
+    {
+        return openAsync(filepath);
+    }
+
     bool success = false;
     ofJson json;
     ofXml xml;
+    MTBinaryReader binary;
+
+    if (streamingOpen && serializerType != BINARY)
+    {
+        MTStreamingReader stream;
+        auto format = serializerType == XML ? MTStreamingReader::FormatXML
+                                            : MTStreamingReader::FormatJSON;
+        if (!stream.open(ofToDataPath(filepath, true), format))
+        {
+            ofLogError("MTApp") << "Failed loading file " << filepath;
+            return false;
+        }
+        return applyOpenedDocument(filepath, xml, json, binary, &stream);
+    }
 
     if (serializerType == XML)
     {
         success = xml.load(filepath);
     }
-    else
+    else if (serializerType == JSON)
     {
         try
         {
@@ -907,24 +1241,58 @@ bool MTApp::openImpl(std::string path)
             success = false;
         }
     }
+    else
+    {
+        success = binary.open(ofToDataPath(filepath, true));
+    }
 
     if (!success)
     {
         ofLogError("MTApp") << "Failed loading file " << filepath;
         return false;
     }
+    return applyOpenedDocument(filepath, xml, json, binary);
+}
+
+/// The part of opening a file that runs on the main thread, once the file is
+/// parsed.
+bool MTApp::applyOpenedDocument(const std::string& filepath,
+                                ofXml& xml,
+                                ofJson& json,
+                                MTBinaryReader& binary,
+                                MTStreamingReader* stream)
+{
+    MT_PROFILE_SCOPE("MTApp::applyOpenedDocument");
     newFile();
     ofLogVerbose("MTApp") << "Opening file: " << filepath;
-    if (serializerType == XML)
+    if (stream != nullptr)
+    {
+        model->deserialize(*stream);
+        if (!stream->getError().empty())
+        {
+            ofLogError("MTApp") << "Failed loading file " << filepath << ": "
+                                << stream->getError();
+            newFile();
+            return false;
+        }
+    }
+    else if (serializerType == XML)
     {
         preDeserializeXMLEvent.notify(xml);
         model->deserialize(xml);
     }
-    else
+    else if (serializerType == JSON)
     {
         preDeserializeJsonEvent.notify(json);
         model->deserialize(json);
     }
+    else
+    {
+        preDeserializeBinaryEvent.notify(binary);
+        model->deserialize(binary);
+    }
+    replayJournal(ofToDataPath(filepath, true));
+    model->markSaved();
 
     if (model == nullptr)
     {
@@ -946,6 +1314,210 @@ bool MTApp::openImpl(std::string path)
     return true;
 }
 
+namespace
+{
+/// Reads a whole file in chunks, reporting the fraction read so far.
+bool readFile(const std::string& path,
+              std::string& contents,
+              const std::function<void(float)>& progress)
+{
+    std::ifstream is(path, std::ios::binary);
+    if (!is)
+        return false;
+    is.seekg(0, std::ios::end);
+    auto size = (size_t)is.tellg();
+    is.seekg(0, std::ios::beg);
+    contents.resize(size);
+
+    const size_t chunkSize = 1 << 20;
+    for (size_t offset = 0; offset < size; offset += chunkSize)
+    {
+        auto count = std::min(chunkSize, size - offset);
+        if (!is.read(&contents[offset], count))
+            return false;
+        progress((float)(offset + count) / size);
+    }
+    return true;
+}
+}  // namespace
+
+void MTApp::postFileOperationEvent(MTFileOperationEventArgs args)
+{
+    fileOperationQueue.enqueue(
+        [this, args]() mutable
+        {
+            fileOperationEvent.notify(args);
+        });
+}
+
+bool MTApp::openAsync(std::string filepath)
+{
+    if (fileOperationInProgress)
+    {
+        ofLogError("MTApp") << "Cannot open " << filepath
+                            << " while another file operation is in progress";
+        return false;
+    }
+    fileOperationInProgress = true;
+
+    MTFileOperationEventArgs args;
+    args.operation = MTFileOperationEventArgs::Open;
+    args.filePath = filepath;
+    fileOperationEvent.notify(args);
+
+    auto type = serializerType;
+    auto dataPath = ofToDataPath(filepath, true);
+    fileOperation = std::async(
+        std::launch::async,
+        [this, dataPath, type, args]() mutable
+        {
+            MT_PROFILE_SCOPE("MTApp::openAsync");
+            // Reading is the first half of the progress, parsing the next 40%:
+            std::string contents;
+            bool success = readFile(dataPath,
+                                    contents,
+                                    [this, &args](float fraction)
+                                    {
+                                        args.progress = fraction * 0.5f;
+                                        postFileOperationEvent(args);
+                                    });
+
+            auto xml = std::make_shared<ofXml>();
+            auto json = std::make_shared<ofJson>();
+            auto binary = std::make_shared<MTBinaryReader>();
+            if (success)
+            {
+                if (type == XML)
+                {
+                    success = xml->parse(contents);
+                }
+                else if (type == BINARY)
+                {
+                    // Reading it here rather than mapping it keeps the page
+                    // faults off the main thread:
+                    success = binary->parse(std::move(contents));
+                }
+                else
+                {
+                    try
+                    {
+                        *json = ofJson::parse(contents);
+                        success = json->empty() ? false : true;
+                    }
+                    catch (std::exception& e)
+                    {
+                        success = false;
+                    }
+                }
+            }
+            contents.clear();
+            contents.shrink_to_fit();
+            args.progress = 0.9f;
+            postFileOperationEvent(args);
+
+            fileOperationQueue.enqueue(
+                [this, args, xml, json, binary, success]() mutable
+                {
+                    fileOperationInProgress = false;
+                    if (!success)
+                    {
+                        ofLogError("MTApp")
+                            << "Failed loading file " << args.filePath;
+                    }
+                    args.success =
+                        success &&
+                        applyOpenedDocument(
+                            args.filePath, *xml, *json, *binary);
+                    args.progress = 1;
+                    args.isFinished = true;
+                    fileOperationEvent.notify(args);
+                });
+        });
+    return true;
+}
+
+bool MTApp::saveAsync()
+{
+    auto filepath = MTPrefLastFile.get();
+    if (fileOperationInProgress)
+    {
+        ofLogError("MTApp") << "Cannot save " << filepath
+                            << " while another file operation is in progress";
+        return false;
+    }
+    fileOperationInProgress = true;
+
+    modelWillSaveEvent.notify();
+
+    // The snapshot of the model is taken here, the worker only turns it into
+    // text and writes it:
+    auto xml = std::make_shared<ofXml>();
+    auto json = std::make_shared<ofJson>();
+    auto binary = std::make_shared<MTBinaryWriter>();
+    if (serializerType == XML)
+    {
+        model->serialize(*xml);
+    }
+    else if (serializerType == JSON)
+    {
+        model->serialize(*json);
+    }
+    else
+    {
+        model->serialize(*binary);
+    }
+
+    MTFileOperationEventArgs args;
+    args.operation = MTFileOperationEventArgs::Save;
+    args.filePath = filepath;
+    args.progress = 0.5f;
+    fileOperationEvent.notify(args);
+
+    auto type = serializerType;
+    auto dataPath = ofToDataPath(filepath, true);
+    auto isCopy = isSavingCopy;
+    beginFullSave(dataPath, isCopy);
+    fileOperation = std::async(
+        std::launch::async,
+        [this, dataPath, isCopy, type, xml, json, binary, args]() mutable
+        {
+            MT_PROFILE_SCOPE("MTApp::saveAsync");
+            std::string contents;
+            if (type == XML)
+            {
+                contents = xml->toString();
+            }
+            else if (type == JSON)
+            {
+                contents = json->dump(4);
+            }
+            else
+            {
+                contents = binary->toString();
+            }
+            args.success =
+                MTAppFramework::WriteFileAtomically(dataPath, contents);
+            auto hash = HashDocument(contents);
+            if (!args.success)
+            {
+                ofLogError("MTApp")
+                    << "Encountered an error while saving " << args.filePath;
+            }
+
+            fileOperationQueue.enqueue(
+                [this, dataPath, isCopy, args, hash]() mutable
+                {
+                    fileOperationInProgress = false;
+                    finishFullSave(dataPath, isCopy, args.success, hash);
+                    args.progress = 1;
+                    args.isFinished = true;
+                    fileOperationEvent.notify(args);
+                });
+        });
+    saveAppPreferences();
+    return true;
+}
+
 void MTApp::newFile()
 {
     // Call the user's newFile method:
@@ -956,6 +1528,9 @@ void MTApp::newFile()
     MTPrefLastFile = "";
     fileName = "";
     model->newFile();
+    model->markSaved();
+    journalBasePath = "";
+    isJournalBaseHashed = false;
     ofEventArgs fooArgs;
     newFileEvent.notify();
     isInitialized = true;
@@ -980,13 +1555,88 @@ bool MTApp::saveAppPreferences()
     // Prevents bogus window prefs from being saved
     if (!isInitialized)
         return false;
+    isAppPreferencesDirty = true;
+    if (appPreferencesSaveInterval == 0)
+    {
+        return flushAppPreferences();
+    }
+    return true;
+}
+
+namespace
+{
+int64_t steadyMillis()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+}  // namespace
+
+bool MTApp::flushAppPreferences()
+{
+    if (!isInitialized)
+        return false;
+
+    // Let a write in progress finish first, so that it can't land after ours:
+    bool success = true;
+    if (appPreferencesWrite.valid())
+    {
+        success = appPreferencesWrite.get();
+    }
+
+    if (isAppPreferencesDirty)
+    {
+        isAppPreferencesDirty = false;
+        lastAppPreferencesWrite = steadyMillis();
+        ofXml appPrefsXml;
+        std::vector<WindowParams> windowParams;
+        snapshotAppPreferences(appPrefsXml, windowParams);
+        success = writeAppPreferences(std::move(appPrefsXml),
+                                      std::move(windowParams),
+                                      appPreferencesPath);
+    }
+    return success;
+}
+
+void MTApp::writePendingAppPreferences()
+{
+    if (!isAppPreferencesDirty)
+        return;
+
+    if (appPreferencesWrite.valid())
+    {
+        if (appPreferencesWrite.wait_for(std::chrono::seconds(0)) !=
+            std::future_status::ready)
+        {
+            return;
+        }
+        appPreferencesWrite.get();
+    }
+
+    auto now = steadyMillis();
+    if (now - lastAppPreferencesWrite < (int64_t)appPreferencesSaveInterval)
+        return;
+
+    isAppPreferencesDirty = false;
+    lastAppPreferencesWrite = now;
     ofXml appPrefsXml;
-    // appPrefsXml.removeChild("App_Preferences");
-    ofSerialize(appPrefsXml, appPreferences);
+    std::vector<WindowParams> windowParams;
+    snapshotAppPreferences(appPrefsXml, windowParams);
+    appPreferencesWrite = std::async(std::launch::async,
+                                     &MTApp::writeAppPreferences,
+                                     std::move(appPrefsXml),
+                                     std::move(windowParams),
+                                     appPreferencesPath);
+}
 
-    auto root = appPrefsXml.getChild("App_Preferences");
-    root.removeChild("Windows");
-    auto windowsXml = root.appendChild("Windows");
+/// Copies everything that goes into the preferences file. Main thread only,
+/// since it reads the parameters and asks GLFW about monitors.
+void MTApp::snapshotAppPreferences(ofXml& appPrefsXml,
+                                   std::vector<WindowParams>& windowParams)
+{
+    MT_PROFILE_SCOPE("MTApp::snapshotAppPreferences");
+    ofSerialize(appPrefsXml, appPreferences);
 
     for (auto& wp : wpMap)
     {
@@ -1012,8 +1662,6 @@ bool MTApp::saveAppPreferences()
             wp.second.size = glm::max(wp.second.size, {200, 200});
         }
 
-        auto winCenter = wp.second.position + (wp.second.size * 0.5);
-
         auto w = getWindowWithName(wp.first);
         if (w)
         {
@@ -1031,15 +1679,31 @@ bool MTApp::saveAppPreferences()
             }
         }
 
+        windowParams.push_back(wp.second);
+        windowParams.back().name = wp.first;
+    }
+}
+
+/// Builds and writes the preferences file. Safe to call from any thread.
+bool MTApp::writeAppPreferences(ofXml appPrefsXml,
+                                std::vector<WindowParams> windowParams,
+                                std::filesystem::path path)
+{
+    MT_PROFILE_SCOPE("MTApp::writeAppPreferences");
+    auto root = appPrefsXml.getChild("App_Preferences");
+    root.removeChild("Windows");
+    auto windowsXml = root.appendChild("Windows");
+    for (auto& wp : windowParams)
+    {
         auto winXml = windowsXml.appendChild("Window");
-        winXml.appendChild("Name").set(wp.first);
-        winXml.appendChild("Position").set(wp.second.position);
-        winXml.appendChild("Size").set(wp.second.size);
+        winXml.appendChild("Name").set(wp.name);
+        winXml.appendChild("Position").set(wp.position);
+        winXml.appendChild("Size").set(wp.size);
     }
-    ofDisableDataPath();
-    auto success = appPrefsXml.save(appPreferencesPath);
-    ofEnableDataPath();
-    return success;
+
+    // So that a crash halfway through can't leave a truncated preferences
+    // file behind:
+    return MTAppFramework::WriteFileAtomically(path, appPrefsXml.toString());
 }
 
 GLFWmonitor* MTApp::getMonitorForWindow(MTWindow* w)
@@ -1155,49 +1819,10 @@ int mtGetLocalMouseY()
     return -1;
 }
 
-ofPath MTApp::pathFromString(std::string s)
+ofPath MTApp::pathFromString(std::string_view s)
 {
-    std::vector<std::string> commandStrings = ofSplitString(s, "{", true, true);
     ofPath thePath;
-
-    for (auto cs : commandStrings)
-    {
-        std::vector<std::string> commandStringElements =
-            ofSplitString(cs, ";", true, true);
-
-        ofPath::Command* thisCommand;
-        int commandType = ofToInt(commandStringElements[0]);
-        ofPoint p, cp1, cp2;
-        switch (commandType)
-        {
-            case ofPath::Command::moveTo:
-                p = ofFromString<ofPoint>(commandStringElements[1]);
-                thePath.moveTo(p);
-                break;
-            case ofPath::Command::lineTo:
-                p = ofFromString<ofPoint>(commandStringElements[1]);
-                thePath.lineTo(p);
-                break;
-            case ofPath::Command::curveTo:
-                p = ofFromString<ofPoint>(commandStringElements[1]);
-                thePath.curveTo(p);
-            case ofPath::Command::bezierTo:
-                p = ofFromString<ofPoint>(commandStringElements[1]);
-                cp1 = ofFromString<ofPoint>(commandStringElements[2]);
-                cp2 = ofFromString<ofPoint>(commandStringElements[3]);
-                thePath.bezierTo(cp1, cp2, p);
-                break;
-            case ofPath::Command::close:
-                thePath.close();
-                break;
-            default:
-                ofLogWarning("MTApp") << "pathFromString: A Path Command "
-                                         "supplied is not implemented";
-
-                break;
-        }
-    }
-
+    MTAppFramework::ParsePathCommands(s, thePath);
     return thePath;
 }
 
@@ -2,9 +2,13 @@
 #define ofxMTApp_hpp
 
 #include <utils/ofXml.h>
+#include <future>
 #include <unordered_map>
 #include "GLFW/glfw3.h"
 #include "MTAppFrameworkUtils.hpp"
+#include "MTBinarySerializer.hpp"
+#include "MTOperationQueue.hpp"
+#include "MTStreamingReader.hpp"
 #include "ofxImGui.h"
 #include "ofAppGLFWWindow.h"
 #include "ofBaseApp.h"
@@ -40,6 +44,28 @@ class MTDisplay
     int getId() const { return id; }
 };
 
+/**
+ * @brief Reports the progress of an asynchronous open or save. Always notified
+ * on the main thread.
+ */
+class MTFileOperationEventArgs : public ofEventArgs
+{
+   public:
+    enum Operation
+    {
+        Open,
+        Save
+    };
+
+    Operation operation = Open;
+    std::string filePath;
+    /// From 0 to 1.
+    float progress = 0;
+    bool isFinished = false;
+    /// Only meaningful once isFinished is true.
+    bool success = false;
+};
+
 class MTApp : public ofBaseApp, public MTEventListenerStore
 {
    public:
@@ -48,7 +74,10 @@ class MTApp : public ofBaseApp, public MTEventListenerStore
     enum SerializerType
     {
         XML,
-        JSON
+        JSON,
+        /// See MTBinaryWriter. Much faster to load and save than the text
+        /// formats, but not human readable.
+        BINARY
     };
 
     struct MTAppSettings
@@ -196,9 +225,19 @@ class MTApp : public ofBaseApp, public MTEventListenerStore
     std::weak_ptr<MTWindow> getMainWindow();
 
 #ifndef TARGET_RASPBERRY_PI
-//	std::shared_ptr<MTOffscreenWindow>
-//	createOffscreenWindow(std::string windowName, ofGLFWWindowSettings&
-// settings, bool useTextureRectangle = true);
+    /**
+     * @brief Creates a hidden window that renders into an FBO, for batch
+     * rendering and headless machines. See MTOffscreenWindow. Once the app is
+     * running, the OpenGL context is shared with the Main Window unless the
+     * settings say otherwise. The size of the window comes from the settings,
+     * it is not saved in the app preferences.
+     * @param windowName must not be in use by any other window, otherwise
+     * createOffscreenWindow returns nullptr.
+     * @param settings visible and numSamples are ignored.
+     */
+    std::shared_ptr<MTOffscreenWindow>
+    createOffscreenWindow(std::string windowName,
+                          ofGLFWWindowSettings settings);
 #endif
 
 #ifdef TARGET_OPENGLES
@@ -267,7 +306,97 @@ class MTApp : public ofBaseApp, public MTEventListenerStore
     bool open(std::string filepath = "");
     void save();
     bool revert();
+
+    /**
+     * @brief Schedules a write of the app preferences and window positions.
+     * Writes are coalesced: the preferences are written on a background
+     * thread at most once per save interval, from a snapshot taken on the main
+     * thread, so it is cheap to call this on every change.
+     * @return false if the app hasn't finished initializing, in which case
+     * nothing is saved.
+     */
     bool saveAppPreferences();
+
+    /**
+     * @brief Writes any pending changes to the app preferences right away,
+     * waiting for a background write in progress to finish first. Called
+     * when the app exits.
+     * @return True if the preferences file is up to date.
+     */
+    bool flushAppPreferences();
+
+    /**
+     * @brief When enabled, opening, saving and reverting documents happen on a
+     * background thread, so that windows keep rendering while a large document
+     * loads. On open, the file is read and parsed on the worker; the
+     * preDeserialize events, MTModel::deserialize and modelLoadedEvent still
+     * run on the main thread. On save, the model is serialized on the main
+     * thread and the file is written on the worker, through a temporary file
+     * that replaces the old one once it's complete. open() and save() return
+     * once the operation has started; follow fileOperationEvent to learn
+     * how it went. Only one operation runs at a time. Disabled by default.
+     */
+    void setAsyncFileOperations(bool async) { asyncFileOperations = async; }
+    bool getAsyncFileOperations() const { return asyncFileOperations; }
+
+    /**
+     * @brief True while an asynchronous open or save is running.
+     */
+    bool isFileOperationInProgress() const { return fileOperationInProgress; }
+
+    /**
+     * @brief Notifies the progress of asynchronous opens and saves, on the
+     * main thread.
+     */
+    ofEvent<MTFileOperationEventArgs> fileOperationEvent;
+
+    /**
+     * @brief The minimum time between two writes of the app preferences file,
+     * in milliseconds. The default is 500. With 0, every call to
+     * saveAppPreferences() writes the file synchronously.
+     */
+    void setAppPreferencesSaveInterval(uint64_t ms)
+    {
+        appPreferencesSaveInterval = ms;
+    }
+
+    /**
+     * @brief When enabled, saving the document that was last opened or saved
+     * only appends the parameters that changed since then to a journal next to
+     * it (its path plus ".journal"), so the cost of a save follows the size of
+     * the edit rather than the size of the document. Opening the document
+     * replays its journal. The whole document is written again, and the journal
+     * dropped, when the journal grows past the compaction size, when the Model
+     * calls MTModel::setNeedsFullSave(), and on Save As. saveCopy() always
+     * writes the whole document. Journal entries are appended on the main
+     * thread, and are not notified through fileOperationEvent. Disabled by
+     * default.
+     */
+    void setJournaledSaves(bool journaled) { journaledSaves = journaled; }
+    bool getJournaledSaves() const { return journaledSaves; }
+
+    /**
+     * @brief The size of the journal, in bytes, past which the next save
+     * writes the whole document. The default is 4 MB.
+     */
+    void setJournalCompactionSize(size_t bytes)
+    {
+        journalCompactionSize = bytes;
+    }
+
+    /**
+     * @brief When enabled, XML and JSON documents are opened with
+     * MTModel::deserialize(MTStreamingReader&), which sets the parameters as
+     * the file is read, in small chunks, instead of loading the whole document
+     * into an ofXml or ofJson first. The preDeserialize events are not
+     * notified, since there is no document to pass them. A malformed document
+     * is only found out while it's read, in which case the Model is reset with
+     * newFile(). Only synchronous opens stream; with asynchronous file
+     * operations, the document is still parsed on the worker. Disabled by
+     * default.
+     */
+    void setStreamingOpen(bool streaming) { streamingOpen = streaming; }
+    bool getStreamingOpen() const { return streamingOpen; }
     void newFile();
     void saveCopy(std::string filename);
 
@@ -319,7 +448,7 @@ class MTApp : public ofBaseApp, public MTEventListenerStore
      * @return an ofPath. If the string parsing fails the path will
      * be empty. TODO: Catching parsing errors.
      */
-    static ofPath pathFromString(std::string s);
+    static ofPath pathFromString(std::string_view s);
 
     ofParameter<std::string> MTPrefLastFile;
     ofParameter<bool> MTPrefAutoloadLastFile;
@@ -389,6 +518,13 @@ class MTApp : public ofBaseApp, public MTEventListenerStore
      */
     ofEvent<ofXml> preDeserializeXMLEvent;
 
+    /**
+     * @brief Notifies after a document file has been opened, but prior to
+     * MTModel::deserialize being called. Use this version of the event if your
+     * app's serializer type is BINARY.
+     */
+    ofEvent<MTBinaryReader> preDeserializeBinaryEvent;
+
     /**
      * Notifies prior to the model being serialized and saved to disk.
      */
@@ -522,6 +658,41 @@ class MTApp : public ofBaseApp, public MTEventListenerStore
     bool saveAsImpl(std::string newName);
     bool saveImpl();
     bool openImpl(std::string file);
+    bool openAsync(std::string filepath);
+    bool saveAsync();
+    bool applyOpenedDocument(const std::string& filepath,
+                             ofXml& xml,
+                             ofJson& json,
+                             MTBinaryReader& binary,
+                             MTStreamingReader* stream = nullptr);
+    void postFileOperationEvent(MTFileOperationEventArgs args);
+    bool canAppendToJournal(const std::string& dataPath);
+    bool appendToJournal(const std::string& dataPath);
+    void replayJournal(const std::string& dataPath);
+    void beginFullSave(const std::string& dataPath, bool isCopy);
+    void finishFullSave(const std::string& dataPath,
+                        bool isCopy,
+                        bool success,
+                        uint32_t documentHash);
+
+    bool asyncFileOperations = false;
+    bool fileOperationInProgress = false;
+    // Worker threads post their results here, drained on the main loop:
+    MTOperationQueue fileOperationQueue;
+    // Declared after the queue, so that its destructor waits for the worker
+    // before the queue goes away:
+    std::future<void> fileOperation;
+
+    bool streamingOpen = false;
+    bool journaledSaves = false;
+    size_t journalCompactionSize = 4 << 20;
+    bool isSavingCopy = false;
+    // The data path of the document that the journal entries are relative to:
+    std::string journalBasePath;
+    // Its hash, written into every entry so that entries of an older document
+    // are never applied to a newer one:
+    uint32_t journalBaseHash = 0;
+    bool isJournalBaseHashed = false;
 
     void loadAppPreferences();
     ofEventListeners prefEventListeners;
@@ -535,6 +706,20 @@ class MTApp : public ofBaseApp, public MTEventListenerStore
 
     std::unordered_map<std::string, WindowParams> wpMap;
 
+    bool isAppPreferencesDirty = false;
+    uint64_t appPreferencesSaveInterval = 500;
+    // In steady clock milliseconds:
+    int64_t lastAppPreferencesWrite = 0;
+    std::future<bool> appPreferencesWrite;
+    ofEventListener appPreferencesWriteListener;
+
+    void writePendingAppPreferences();
+    void snapshotAppPreferences(ofXml& xml,
+                                std::vector<WindowParams>& windowParams);
+    static bool writeAppPreferences(ofXml xml,
+                                    std::vector<WindowParams> windowParams,
+                                    std::filesystem::path path);
+
     GLFWmonitor* getMonitorForWindow(MTWindow* w);
 
     /**
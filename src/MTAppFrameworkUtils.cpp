@@ -5,6 +5,14 @@
 #include "ImHelpers.h"
 #include <imgui_internal.h>
 #include <utils/ofXml.h>
+#include <algorithm>
+#include <charconv>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 
 ///////////////////////////////////////////
 /// MTProcedure
@@ -190,6 +198,35 @@ void MTAppFramework::RemoveAllParameters(ofParameterGroup& group)
    while (group.size() > 0) group.remove(group.size() - 1);
 }
 
+bool MTAppFramework::WriteFileAtomically(const std::filesystem::path& path, const std::string& contents)
+{
+   auto tempPath = path;
+   tempPath += ".tmp";
+   std::error_code error;
+   {
+      std::ofstream os(tempPath, std::ios::binary | std::ios::trunc);
+      os.write(contents.data(), contents.size());
+      // Small files are only written when the buffer is flushed, so errors
+      // such as a full disk only show up here:
+      os.close();
+      if (!os)
+      {
+         ofLogError("MTAppFramework") << "Could not write " << tempPath;
+         std::filesystem::remove(tempPath, error);
+         return false;
+      }
+   }
+
+   std::filesystem::rename(tempPath, path, error);
+   if (error)
+   {
+      ofLogError("MTAppFramework") << "Could not replace " << path << ": " << error.message();
+      std::filesystem::remove(tempPath, error);
+      return false;
+   }
+   return true;
+}
+
 std::string MTAppFramework::PathToString(ofPath& path)
 {
    std::vector<ofPath::Command> commands = path.getCommands();
@@ -292,46 +329,452 @@ ofPath MTAppFramework::PathFromString2(std::string s)
    return path;
 }
 
-ofPath MTAppFramework::PathFromString(std::string s)
+ofPath MTAppFramework::PathFromString(std::string_view s)
 {
-   std::vector<std::string> commandStrings = ofSplitString(s, "{", true, true);
    ofPath thePath;
    thePath.setFilled(false);
    thePath.setStrokeColor(ofColor::chocolate);
    thePath.setStrokeWidth(2);
-   for (auto cs : commandStrings)
+   ParsePathCommands(s, thePath);
+   return thePath;
+}
+
+namespace
+{
+bool IsPathSeparator(char c)
+{
+   return c == ' ' || c == ',' || c == '\t' || c == '\n' || c == '\r';
+}
+
+/// Parses the number at s[i], advancing i past it.
+bool ParsePathNumber(std::string_view s, size_t& i, float& value)
+{
+   if (i < s.size() && s[i] == '+') i++;
+   const char* first = s.data() + i;
+   const char* last = s.data() + s.size();
+#ifdef __cpp_lib_to_chars
+   auto result = std::from_chars(first, last, value);
+   if (result.ec == std::errc::invalid_argument) return false;
+   i = result.ptr - s.data();
+#else
+   // Not every standard library can parse floats with from_chars yet:
+   char buffer[64];
+   size_t length = std::min<size_t>(last - first, sizeof(buffer) - 1);
+   std::memcpy(buffer, first, length);
+   buffer[length] = 0;
+   char* end;
+   value = std::strtof(buffer, &end);
+   if (end == buffer) return false;
+   i += end - buffer;
+#endif
+   return true;
+}
+
+/// Parses "x, y, z", as written by ofToString. Missing coordinates, or a
+/// missing point, are 0.
+bool ParsePathPoint(std::string_view field, glm::vec3& point)
+{
+   point = glm::vec3(0, 0, 0);
+   size_t i = 0;
+   for (int axis = 0; axis < 3; axis++)
    {
-      std::vector<std::string> commandStringElements = ofSplitString(cs, ";", true, true);
+      while (i < field.size() && IsPathSeparator(field[i])) i++;
+      if (i == field.size()) return true;
+      if (!ParsePathNumber(field, i, point[axis])) return false;
+   }
+   return true;
+}
 
-      int commandType = ofToInt(commandStringElements[0]);
-      ofPoint p, cp1, cp2;
-      switch (commandType)
+/// The next ';' separated field of a command, advancing `command` past it.
+std::string_view NextPathField(std::string_view& command)
+{
+   auto end = command.find(';');
+   auto field = command.substr(0, end);
+   command.remove_prefix(end == std::string_view::npos ? command.size() : end + 1);
+   return field;
+}
+}
+
+bool MTAppFramework::ParsePathCommands(std::string_view s, ofPath& path)
+{
+   auto& commands = path.getCommands();
+   commands.reserve(commands.size() + std::count(s.begin(), s.end(), '{'));
+
+   bool success = true;
+   size_t i = 0;
+   while ((i = s.find('{', i)) != std::string_view::npos)
+   {
+      i++;
+      auto end = s.find_first_of("{}", i);
+      auto command = s.substr(i, end == std::string_view::npos ? std::string_view::npos : end - i);
+      i += command.size();
+
+      auto typeField = NextPathField(command);
+      while (!typeField.empty() && IsPathSeparator(typeField.front())) typeField.remove_prefix(1);
+      int type;
+      if (std::from_chars(typeField.data(), typeField.data() + typeField.size(), type).ec != std::errc())
       {
-      case ofPath::Command::moveTo:
-         p = ofFromString<ofPoint>(commandStringElements[1]);
-         thePath.moveTo(p);
+         ofLogError("MTAppFramework") << "ParsePathCommands: Could not parse a Path Command type";
+         success = false;
          break;
-      case ofPath::Command::lineTo:
-         p = ofFromString<ofPoint>(commandStringElements[1]);
-         thePath.lineTo(p);
+      }
+
+      glm::vec3 to, cp1, cp2;
+      if (!ParsePathPoint(NextPathField(command), to) || !ParsePathPoint(NextPathField(command), cp1) ||
+          !ParsePathPoint(NextPathField(command), cp2))
+      {
+         ofLogError("MTAppFramework") << "ParsePathCommands: Could not parse a Path Command point";
+         success = false;
          break;
-      case ofPath::Command::curveTo: p = ofFromString<ofPoint>(commandStringElements[1]); thePath.curveTo(p);
+      }
+
+      switch (type)
+      {
+      case ofPath::Command::moveTo:
+      case ofPath::Command::lineTo:
+      case ofPath::Command::curveTo:
       case ofPath::Command::bezierTo:
-         p = ofFromString<ofPoint>(commandStringElements[1]);
-         cp1 = ofFromString<ofPoint>(commandStringElements[2]);
-         cp2 = ofFromString<ofPoint>(commandStringElements[3]);
-         thePath.bezierTo(cp1, cp2, p);
+      case ofPath::Command::quadBezierTo:
+         commands.emplace_back(ofPath::Command::Type(type), to, cp1, cp2);
          break;
-      case ofPath::Command::close: thePath.close(); break;
+      case ofPath::Command::close: commands.emplace_back(ofPath::Command::close); break;
       default:
          ofLog(OF_LOG_WARNING,
-               "MTApp::pathFromString: A Path Command "
+               "MTAppFramework::ParsePathCommands: A Path Command "
                "supplied is not implemented");
          break;
       }
    }
 
-   return thePath;
+   path.flagShapeChanged();
+   return success;
+}
+
+namespace
+{
+const char PackedPathMagic[4] = {'M', 'T', 'P', 'K'};
+const uint8_t PackedPathVersion = 1;
+const uint8_t PackedPathQuantized = 1;
+const uint8_t PackedPathFilled = 2;
+const char Base64Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+template<typename T>
+void PutPacked(std::string& out, T value)
+{
+   out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+/// Zigzag encoded, so that small negative differences are small too.
+void PutVarint(std::string& out, uint32_t value)
+{
+   uint32_t zigzag = (value << 1) ^ uint32_t(int32_t(value) >> 31);
+   while (zigzag >= 0x80)
+   {
+      out += char(zigzag | 0x80);
+      zigzag >>= 7;
+   }
+   out += char(zigzag);
+}
+
+struct PackedPathReader
+{
+   std::string_view data;
+   size_t position = 0;
+   bool isValid = true;
+
+   template<typename T>
+   T get()
+   {
+      T value{};
+      if (data.size() - position < sizeof(T))
+      {
+         isValid = false;
+         return value;
+      }
+      std::memcpy(&value, data.data() + position, sizeof(T));
+      position += sizeof(T);
+      return value;
+   }
+
+   uint32_t getVarint()
+   {
+      uint32_t zigzag = 0;
+      for (int shift = 0; shift < 35; shift += 7)
+      {
+         if (position == data.size()) break;
+         uint8_t byte = data[position++];
+         zigzag |= uint32_t(byte & 0x7F) << shift;
+         if ((byte & 0x80) == 0) return (zigzag >> 1) ^ -(zigzag & 1);
+      }
+      isValid = false;
+      return 0;
+   }
+};
+
+/// The number of points a command stores: the control points before `to`.
+int PackedPathPointCount(ofPath::Command::Type type)
+{
+   switch (type)
+   {
+   case ofPath::Command::bezierTo:
+   case ofPath::Command::quadBezierTo: return 3;
+   case ofPath::Command::close: return 0;
+   default: return 1;
+   }
+}
+
+bool IsArcCommand(ofPath::Command::Type type)
+{
+   return type == ofPath::Command::arc || type == ofPath::Command::arcNegative;
+}
+
+std::string EncodeBase64(std::string_view data)
+{
+   std::string out;
+   out.reserve((data.size() + 2) / 3 * 4);
+   size_t i = 0;
+   for (; i + 2 < data.size(); i += 3)
+   {
+      uint32_t bits = uint8_t(data[i]) << 16 | uint8_t(data[i + 1]) << 8 | uint8_t(data[i + 2]);
+      out += Base64Alphabet[bits >> 18];
+      out += Base64Alphabet[bits >> 12 & 0x3F];
+      out += Base64Alphabet[bits >> 6 & 0x3F];
+      out += Base64Alphabet[bits & 0x3F];
+   }
+   if (i < data.size())
+   {
+      bool hasTwo = i + 1 < data.size();
+      uint32_t bits = uint8_t(data[i]) << 16 | (hasTwo ? uint8_t(data[i + 1]) << 8 : 0);
+      out += Base64Alphabet[bits >> 18];
+      out += Base64Alphabet[bits >> 12 & 0x3F];
+      out += hasTwo ? Base64Alphabet[bits >> 6 & 0x3F] : '=';
+      out += '=';
+   }
+   return out;
+}
+
+/// Skips line breaks and anything else outside the alphabet.
+void DecodeBase64(std::string_view text, std::string& out)
+{
+   out.reserve(out.size() + text.size() / 4 * 3);
+   uint32_t bits = 0;
+   int bitCount = 0;
+   for (char c : text)
+   {
+      auto digit = std::strchr(Base64Alphabet, c);
+      if (c == 0 || digit == nullptr) continue;
+      bits = bits << 6 | uint32_t(digit - Base64Alphabet);
+      bitCount += 6;
+      if (bitCount >= 8)
+      {
+         bitCount -= 8;
+         out += char(bits >> bitCount);
+      }
+   }
+}
+}
+
+std::string MTAppFramework::PathToPacked(const ofPath& path, float quantization)
+{
+   const auto& commands = path.getCommands();
+   bool isQuantized = quantization > 0;
+
+   std::string out;
+   out.reserve(32 + commands.size() * (isQuantized ? 8 : 16));
+   out.append(PackedPathMagic, 4);
+   PutPacked<uint8_t>(out, PackedPathVersion);
+   PutPacked<uint8_t>(out, (isQuantized ? PackedPathQuantized : 0) | (path.isFilled() ? PackedPathFilled : 0));
+   PutPacked<uint16_t>(out, 0);
+   PutPacked<uint32_t>(out, commands.size());
+   PutPacked<float>(out, isQuantized ? quantization : 0);
+   auto fill = path.getFillColor();
+   auto stroke = path.getStrokeColor();
+   for (uint8_t component : {fill.r, fill.g, fill.b, fill.a, stroke.r, stroke.g, stroke.b, stroke.a})
+   {
+      PutPacked<uint8_t>(out, component);
+   }
+   PutPacked<float>(out, path.getStrokeWidth());
+
+   for (const auto& c : commands)
+   {
+      PutPacked<uint8_t>(out, c.type);
+   }
+
+   uint32_t previous[3] = {0, 0, 0};
+   auto putPoint = [&](const glm::vec3& p)
+   {
+      for (int axis = 0; axis < 3; axis++)
+      {
+         if (!isQuantized)
+         {
+            PutPacked<float>(out, p[axis]);
+            continue;
+         }
+         double steps = std::round(double(p[axis]) / quantization);
+         // NaN would pass through the clamp, and converting it is undefined:
+         if (!std::isfinite(steps)) steps = 0;
+         auto value = int32_t(std::clamp(steps, double(INT32_MIN), double(INT32_MAX)));
+         // Unsigned, so that differences wrap around instead of overflowing:
+         PutVarint(out, uint32_t(value) - previous[axis]);
+         previous[axis] = uint32_t(value);
+      }
+   };
+
+   for (const auto& c : commands)
+   {
+      switch (PackedPathPointCount(c.type))
+      {
+      case 3:
+         putPoint(c.cp1);
+         putPoint(c.cp2);
+         putPoint(c.to);
+         break;
+      case 1: putPoint(c.to); break;
+      default: break;
+      }
+      if (IsArcCommand(c.type))
+      {
+         PutPacked<float>(out, c.radiusX);
+         PutPacked<float>(out, c.radiusY);
+         PutPacked<float>(out, c.angleBegin);
+         PutPacked<float>(out, c.angleEnd);
+      }
+   }
+   return out;
+}
+
+std::string MTAppFramework::PathToPackedString(const ofPath& path, float quantization)
+{
+   auto packed = PathToPacked(path, quantization);
+   return std::string(PackedPathMagic, 4) + EncodeBase64(std::string_view(packed).substr(4));
+}
+
+ofPath MTAppFramework::PathFromPacked(std::string_view data)
+{
+   ofPath path;
+   if (data.size() < 5 || data.compare(0, 4, std::string_view(PackedPathMagic, 4)) != 0)
+   {
+      ofLogError("MTAppFramework") << "PathFromPacked: Not a packed path";
+      return path;
+   }
+
+   // The text form has base64 after the magic, the raw form the version:
+   std::string decoded;
+   if (uint8_t(data[4]) != PackedPathVersion)
+   {
+      decoded.append(PackedPathMagic, 4);
+      DecodeBase64(data.substr(4), decoded);
+      data = decoded;
+   }
+
+   PackedPathReader reader{data, 4};
+   auto version = reader.get<uint8_t>();
+   auto flags = reader.get<uint8_t>();
+   reader.get<uint16_t>();
+   auto count = reader.get<uint32_t>();
+   auto quantization = reader.get<float>();
+   uint8_t colors[8];
+   for (auto& component : colors)
+   {
+      component = reader.get<uint8_t>();
+   }
+   auto strokeWidth = reader.get<float>();
+   bool isQuantized = flags & PackedPathQuantized;
+   if (!reader.isValid || version != PackedPathVersion || count > data.size() - reader.position ||
+       (isQuantized && !(quantization > 0)))
+   {
+      ofLogError("MTAppFramework") << "PathFromPacked: The packed path is corrupt";
+      return path;
+   }
+   auto types = data.substr(reader.position, count);
+   reader.position += count;
+
+   uint32_t previous[3] = {0, 0, 0};
+   auto getPoint = [&]()
+   {
+      glm::vec3 p;
+      for (int axis = 0; axis < 3; axis++)
+      {
+         if (!isQuantized)
+         {
+            p[axis] = reader.get<float>();
+            continue;
+         }
+         previous[axis] += reader.getVarint();
+         p[axis] = float(int32_t(previous[axis]) * double(quantization));
+      }
+      return p;
+   };
+
+   auto& commands = path.getCommands();
+   commands.reserve(count);
+   for (auto t : types)
+   {
+      if (uint8_t(t) > ofPath::Command::close)
+      {
+         reader.isValid = false;
+         break;
+      }
+      auto type = ofPath::Command::Type(uint8_t(t));
+
+      glm::vec3 to, cp1, cp2;
+      if (PackedPathPointCount(type) == 3)
+      {
+         cp1 = getPoint();
+         cp2 = getPoint();
+      }
+      if (PackedPathPointCount(type) > 0)
+      {
+         to = getPoint();
+      }
+
+      if (IsArcCommand(type))
+      {
+         auto radiusX = reader.get<float>();
+         auto radiusY = reader.get<float>();
+         auto angleBegin = reader.get<float>();
+         auto angleEnd = reader.get<float>();
+         commands.emplace_back(type, to, radiusX, radiusY, angleBegin, angleEnd);
+      }
+      else if (type == ofPath::Command::close)
+      {
+         commands.emplace_back(type);
+      }
+      else
+      {
+         commands.emplace_back(type, to, cp1, cp2);
+      }
+   }
+
+   if (!reader.isValid)
+   {
+      ofLogError("MTAppFramework") << "PathFromPacked: The packed path is corrupt";
+      return ofPath();
+   }
+   path.flagShapeChanged();
+
+   path.setFillColor(ofColor(colors[0], colors[1], colors[2], colors[3]));
+   path.setFilled(flags & PackedPathFilled);
+   path.setStrokeColor(ofColor(colors[4], colors[5], colors[6], colors[7]));
+   path.setStrokeWidth(strokeWidth);
+   return path;
+}
+
+ofPath MTAppFramework::PathFromAnyString(std::string_view s)
+{
+   auto start = s.find_first_not_of(" \t\r\n");
+   if (start == std::string_view::npos) return ofPath();
+   s.remove_prefix(start);
+
+   if (s.compare(0, 4, std::string_view(PackedPathMagic, 4)) == 0)
+   {
+      return PathFromPacked(s);
+   }
+   if (s.front() == '{')
+   {
+      return PathFromString(s);
+   }
+   return PathFromString2(std::string(s));
 }
 
 MTProcedureStep MTProcedure::getCurrentStep()
@@ -1,8 +1,10 @@
 #pragma once
 //#include "ofMain.h"
 //#include "ofxMTAppFramework.h"
+#include <filesystem>
 #include <functional>
 #include <string>
+#include <string_view>
 #include <queue>
 #include "ofConstants.h"
 #include <events/ofEvent.h>
@@ -106,6 +108,21 @@ class MTEventListenerStore
    ofEventListeners eventListeners;
 };
 
+//------------------------------------------------------//
+// MT-MOUSE-SAMPLE  									//
+//------------------------------------------------------//
+
+/**
+ * @brief A raw mouse position as reported by the windowing system, in
+ * window coordinates, with the time it was received in microseconds since the
+ * app started (see ofGetElapsedTimeMicros()).
+ */
+struct MTMouseSample
+{
+   glm::vec2 position;
+   uint64_t time;
+};
+
 struct ImVec2;
 /**
  * @brief Class containing static utility methods.
@@ -141,7 +158,46 @@ class MTAppFramework
 	 * @return an ofPath. If the string parsing fails the path will
 	 * be empty. TODO: Catching parsing errors.
 	 */
-   static ofPath PathFromString(std::string s);
+   static ofPath PathFromString(std::string_view s);
+
+   /**
+	 * @brief Parses the format written by PathToString and appends the
+	 * commands to the path, which must be in ofPath::COMMANDS mode (the
+	 * default). Reads the numbers in place, without splitting the string.
+	 * @return false if a command could not be parsed. The commands before it
+	 * are appended.
+	 */
+   static bool ParsePathCommands(std::string_view s, ofPath& path);
+
+   /**
+	 * @brief Encodes a path compactly: one byte per command, float32
+	 * coordinates, and the fill and stroke style, like PathToString2.
+	 * @param quantization If greater than 0, coordinates are rounded to
+	 * multiples of it and stored as variable length differences from the
+	 * previous point, which takes a byte or two per coordinate on dense paths.
+	 * NaN and infinite coordinates are stored as 0 when quantized.
+	 * @return The raw bytes, starting with "MTPK".
+	 */
+   static std::string PathToPacked(const ofPath& path, float quantization = 0);
+
+   /**
+	 * @brief PathToPacked, as text that can be embedded in XML or JSON: "MTPK"
+	 * followed by the rest of the bytes in base64. This is what ofPath
+	 * parameters are serialized as.
+	 */
+   static std::string PathToPackedString(const ofPath& path, float quantization = 0);
+
+   /**
+	 * @brief Decodes either form of a packed path.
+	 * @return The path, or an empty path if the data is not valid.
+	 */
+   static ofPath PathFromPacked(std::string_view data);
+
+   /**
+	 * @brief Reads a path in any of the formats that have been used to store
+	 * them: packed, the XML of PathToString2, or PathToString.
+	 */
+   static ofPath PathFromAnyString(std::string_view s);
 
    template<typename T>
    static void FlushThreadChannel(ofThreadChannel<T>& channel);
@@ -151,6 +207,15 @@ class MTAppFramework
 
    static void RemoveAllParameters(ofParameterGroup& group);
 
+   /**
+	 * @brief Writes a file by writing a temporary file next to it and renaming
+	 * it over the original, so that readers never see a partially written
+	 * file. Safe to call from any thread.
+	 * @return false if the file couldn't be written, in which case the original
+	 * is left untouched.
+	 */
+   static bool WriteFileAtomically(const std::filesystem::path& path, const std::string& contents);
+
     template <typename T>
     static T GetRandomElement(const std::vector<T>& v)
     {
@@ -212,7 +277,7 @@ void AddParameter(std::shared_ptr<ofAbstractParameter> parameter);
 
 inline std::ostream& operator<<(std::ostream& os, const ofPath& path)
 {
-   os << MTAppFramework::PathToString2(path);
+   os << MTAppFramework::PathToPackedString(path);
    return os;
 }
 
@@ -225,6 +290,6 @@ inline std::istream& operator>>(std::istream& is, ofPath& path)
       if (!line.empty()) result += line;
    }
 
-   path = MTAppFramework::PathFromString2(result);
+   path = MTAppFramework::PathFromAnyString(result);
    return is;
 }
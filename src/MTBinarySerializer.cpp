@@ -0,0 +1,415 @@
+//
+// Created by Cristobal Mendoza.
+//
+
+#include "MTBinarySerializer.hpp"
+#include <cstring>
+#include <fstream>
+#include "MTAppFrameworkUtils.hpp"
+#include "ofColor.h"
+#include "ofLog.h"
+#include "ofParameter.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+const char DocumentMagic[4] = {'M', 'T', 'B', 'N'};
+const uint32_t DocumentVersion = 1;
+const size_t HeaderSize = 16;
+const size_t DirectoryEntrySize = 24;
+
+size_t align8(size_t n)
+{
+   return (n + 7) & ~size_t(7);
+}
+
+template<typename T>
+void put(std::string& out, T value)
+{
+   out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+T get(const char* data)
+{
+   T value;
+   std::memcpy(&value, data, sizeof(T));
+   return value;
+}
+}
+
+#pragma mark MTBinaryWriter
+
+void MTBinaryWriter::serialize(const ofParameterGroup& group, const std::string& prefix)
+{
+   for (const auto& parameter : group)
+   {
+      auto name = parameter->getEscapedName();
+      write(prefix.empty() ? name : prefix + "/" + name, *parameter);
+   }
+}
+
+void MTBinaryWriter::write(const std::string& key, const ofAbstractParameter& parameter)
+{
+   if (auto group = dynamic_cast<const ofParameterGroup*>(&parameter))
+   {
+      serialize(*group, key);
+      return;
+   }
+   if (!parameter.isSerializable()) return;
+
+   if (auto p = dynamic_cast<const ofParameter<bool>*>(&parameter))
+   {
+      uint8_t value = p->get() ? 1 : 0;
+      append(key, BinaryTypeBool, &value, sizeof(value));
+   }
+   else if (auto p = dynamic_cast<const ofParameter<int>*>(&parameter))
+   {
+      int32_t value = p->get();
+      append(key, BinaryTypeInt, &value, sizeof(value));
+   }
+   else if (auto p = dynamic_cast<const ofParameter<float>*>(&parameter))
+   {
+      append(key, BinaryTypeFloat, &p->get(), sizeof(float));
+   }
+   else if (auto p = dynamic_cast<const ofParameter<double>*>(&parameter))
+   {
+      append(key, BinaryTypeDouble, &p->get(), sizeof(double));
+   }
+   else if (auto p = dynamic_cast<const ofParameter<glm::vec2>*>(&parameter))
+   {
+      append(key, BinaryTypeVec2, &p->get(), sizeof(glm::vec2));
+   }
+   else if (auto p = dynamic_cast<const ofParameter<glm::vec3>*>(&parameter))
+   {
+      append(key, BinaryTypeVec3, &p->get(), sizeof(glm::vec3));
+   }
+   else if (auto p = dynamic_cast<const ofParameter<glm::vec4>*>(&parameter))
+   {
+      append(key, BinaryTypeVec4, &p->get(), sizeof(glm::vec4));
+   }
+   else if (auto p = dynamic_cast<const ofParameter<ofFloatColor>*>(&parameter))
+   {
+      const auto& c = p->get();
+      float value[4] = {c.r, c.g, c.b, c.a};
+      append(key, BinaryTypeFloatColor, value, sizeof(value));
+   }
+   else if (auto p = dynamic_cast<const ofParameter<ofColor>*>(&parameter))
+   {
+      const auto& c = p->get();
+      uint8_t value[4] = {c.r, c.g, c.b, c.a};
+      append(key, BinaryTypeColor, value, sizeof(value));
+   }
+   else if (auto p = dynamic_cast<const ofParameter<ofPath>*>(&parameter))
+   {
+      auto value = MTAppFramework::PathToPacked(p->get());
+      append(key, BinaryTypePath, value.data(), value.size());
+   }
+   else
+   {
+      auto value = parameter.toString();
+      append(key, BinaryTypeString, value.data(), value.size());
+   }
+}
+
+void MTBinaryWriter::writeBlob(const std::string& key, const void* data, size_t size)
+{
+   append(key, BinaryTypeBlob, data, size);
+}
+
+void MTBinaryWriter::append(const std::string& key, MTBinaryType type, const void* data, size_t size)
+{
+   payloads.resize(align8(payloads.size()));
+   entries.push_back({key, type, payloads.size(), size});
+   payloads.append(static_cast<const char*>(data), size);
+}
+
+std::string MTBinaryWriter::toString() const
+{
+   size_t keysSize = 0;
+   for (const auto& e : entries)
+   {
+      keysSize += sizeof(uint32_t) + e.key.size();
+   }
+   size_t directoryOffset = align8(HeaderSize + keysSize);
+   size_t payloadOffset = directoryOffset + entries.size() * DirectoryEntrySize;
+
+   std::string out;
+   out.reserve(payloadOffset + payloads.size());
+   out.append(DocumentMagic, 4);
+   put<uint32_t>(out, DocumentVersion);
+   put<uint32_t>(out, entries.size());
+   put<uint32_t>(out, 0);
+
+   for (const auto& e : entries)
+   {
+      put<uint32_t>(out, e.key.size());
+      out.append(e.key);
+   }
+   out.resize(directoryOffset);
+
+   for (const auto& e : entries)
+   {
+      put<uint8_t>(out, e.type);
+      out.append(7, '\0');
+      put<uint64_t>(out, e.size);
+      put<uint64_t>(out, payloadOffset + e.offset);
+   }
+   out.append(payloads);
+   return out;
+}
+
+bool MTBinaryWriter::save(const std::filesystem::path& path) const
+{
+   return MTAppFramework::WriteFileAtomically(path, toString());
+}
+
+#pragma mark MTBinaryReader
+
+struct MTBinaryReader::MappedFile
+{
+   const char* data = nullptr;
+   size_t size = 0;
+
+   ~MappedFile()
+   {
+#ifndef _WIN32
+      if (data) munmap(const_cast<char*>(data), size);
+#endif
+   }
+};
+
+MTBinaryReader::MTBinaryReader() = default;
+MTBinaryReader::~MTBinaryReader() = default;
+
+bool MTBinaryReader::open(const std::filesystem::path& path)
+{
+   index.clear();
+   file.reset();
+   ownedData.clear();
+   hasDocument = false;
+
+#ifndef _WIN32
+   int fd = ::open(path.c_str(), O_RDONLY);
+   if (fd < 0)
+   {
+      ofLogError("MTBinaryReader") << "Could not open " << path;
+      return false;
+   }
+   struct stat info;
+   if (fstat(fd, &info) != 0 || info.st_size == 0)
+   {
+      ::close(fd);
+      ofLogError("MTBinaryReader") << path << " is empty";
+      return false;
+   }
+   void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+   ::close(fd);
+   if (mapping == MAP_FAILED)
+   {
+      ofLogError("MTBinaryReader") << "Could not map " << path;
+      return false;
+   }
+   file = std::make_unique<MappedFile>();
+   file->data = static_cast<const char*>(mapping);
+   file->size = info.st_size;
+   if (!readTables(file->data, file->size))
+   {
+      ofLogError("MTBinaryReader") << path << " is not a valid binary document";
+      index.clear();
+      file.reset();
+      return false;
+   }
+   return true;
+#else
+   // No mapping on Windows yet, read the whole file instead:
+   std::ifstream is(path, std::ios::binary);
+   if (!is)
+   {
+      ofLogError("MTBinaryReader") << "Could not open " << path;
+      return false;
+   }
+   std::string data((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+   if (!parse(std::move(data)))
+   {
+      ofLogError("MTBinaryReader") << path << " is not a valid binary document";
+      return false;
+   }
+   return true;
+#endif
+}
+
+bool MTBinaryReader::parse(std::string data)
+{
+   index.clear();
+   file.reset();
+   ownedData = std::move(data);
+   hasDocument = false;
+   if (!readTables(ownedData.data(), ownedData.size()))
+   {
+      index.clear();
+      ownedData.clear();
+      return false;
+   }
+   return true;
+}
+
+bool MTBinaryReader::readTables(const char* data, size_t size)
+{
+   if (size < HeaderSize || std::memcmp(data, DocumentMagic, 4) != 0) return false;
+   auto version = get<uint32_t>(data + 4);
+   if (version != DocumentVersion)
+   {
+      ofLogError("MTBinaryReader") << "Unsupported document version " << version;
+      return false;
+   }
+   size_t count = get<uint32_t>(data + 8);
+
+   // Every key takes at least its length:
+   if (count > (size - HeaderSize) / sizeof(uint32_t)) return false;
+   std::vector<std::string_view> keys;
+   keys.reserve(count);
+   size_t pos = HeaderSize;
+   for (size_t i = 0; i < count; i++)
+   {
+      if (size - pos < sizeof(uint32_t)) return false;
+      size_t length = get<uint32_t>(data + pos);
+      pos += sizeof(uint32_t);
+      if (length > size - pos) return false;
+      keys.emplace_back(data + pos, length);
+      pos += length;
+   }
+
+   pos = align8(pos);
+   if (pos > size || count > (size - pos) / DirectoryEntrySize) return false;
+   index.reserve(count);
+   for (size_t i = 0; i < count; i++)
+   {
+      Entry e;
+      e.type = MTBinaryType(get<uint8_t>(data + pos));
+      auto entrySize = get<uint64_t>(data + pos + 8);
+      auto offset = get<uint64_t>(data + pos + 16);
+      if (offset > size || entrySize > size - offset) return false;
+      e.data = data + offset;
+      e.size = entrySize;
+      // Later entries win, like they would when setting parameters in order:
+      index[keys[i]] = e;
+      pos += DirectoryEntrySize;
+   }
+   hasDocument = true;
+   return true;
+}
+
+void MTBinaryReader::deserialize(ofParameterGroup& group, const std::string& prefix)
+{
+   for (auto& parameter : group)
+   {
+      auto name = parameter->getEscapedName();
+      read(prefix.empty() ? name : prefix + "/" + name, *parameter);
+   }
+}
+
+namespace
+{
+template<typename T>
+bool readPayload(const char* data, size_t size, MTBinaryType type, MTBinaryType expectedType, T& value)
+{
+   if (type != expectedType || size != sizeof(T)) return false;
+   std::memcpy(&value, data, sizeof(T));
+   return true;
+}
+}
+
+bool MTBinaryReader::read(const std::string& key, ofAbstractParameter& parameter)
+{
+   if (auto group = dynamic_cast<ofParameterGroup*>(&parameter))
+   {
+      deserialize(*group, key);
+      return true;
+   }
+
+   auto it = index.find(key);
+   if (it == index.end()) return false;
+   const auto& e = it->second;
+
+   if (auto p = dynamic_cast<ofParameter<bool>*>(&parameter))
+   {
+      uint8_t value;
+      if (!readPayload(e.data, e.size, e.type, BinaryTypeBool, value)) return false;
+      p->set(value != 0);
+   }
+   else if (auto p = dynamic_cast<ofParameter<int>*>(&parameter))
+   {
+      int32_t value;
+      if (!readPayload(e.data, e.size, e.type, BinaryTypeInt, value)) return false;
+      p->set(value);
+   }
+   else if (auto p = dynamic_cast<ofParameter<float>*>(&parameter))
+   {
+      float value;
+      if (!readPayload(e.data, e.size, e.type, BinaryTypeFloat, value)) return false;
+      p->set(value);
+   }
+   else if (auto p = dynamic_cast<ofParameter<double>*>(&parameter))
+   {
+      double value;
+      if (!readPayload(e.data, e.size, e.type, BinaryTypeDouble, value)) return false;
+      p->set(value);
+   }
+   else if (auto p = dynamic_cast<ofParameter<glm::vec2>*>(&parameter))
+   {
+      glm::vec2 value;
+      if (!readPayload(e.data, e.size, e.type, BinaryTypeVec2, value)) return false;
+      p->set(value);
+   }
+   else if (auto p = dynamic_cast<ofParameter<glm::vec3>*>(&parameter))
+   {
+      glm::vec3 value;
+      if (!readPayload(e.data, e.size, e.type, BinaryTypeVec3, value)) return false;
+      p->set(value);
+   }
+   else if (auto p = dynamic_cast<ofParameter<glm::vec4>*>(&parameter))
+   {
+      glm::vec4 value;
+      if (!readPayload(e.data, e.size, e.type, BinaryTypeVec4, value)) return false;
+      p->set(value);
+   }
+   else if (auto p = dynamic_cast<ofParameter<ofFloatColor>*>(&parameter))
+   {
+      float value[4];
+      if (e.type != BinaryTypeFloatColor || e.size != sizeof(value)) return false;
+      std::memcpy(value, e.data, sizeof(value));
+      p->set(ofFloatColor(value[0], value[1], value[2], value[3]));
+   }
+   else if (auto p = dynamic_cast<ofParameter<ofColor>*>(&parameter))
+   {
+      if (e.type != BinaryTypeColor || e.size != 4) return false;
+      auto bytes = reinterpret_cast<const uint8_t*>(e.data);
+      p->set(ofColor(bytes[0], bytes[1], bytes[2], bytes[3]));
+   }
+   else if (e.type == BinaryTypePath)
+   {
+      auto p = dynamic_cast<ofParameter<ofPath>*>(&parameter);
+      if (p == nullptr) return false;
+      p->set(MTAppFramework::PathFromPacked(std::string_view(e.data, e.size)));
+   }
+   else
+   {
+      if (e.type != BinaryTypeString) return false;
+      parameter.fromString(std::string(e.data, e.size));
+   }
+   return true;
+}
+
+std::string_view MTBinaryReader::readBlob(std::string_view key) const
+{
+   auto it = index.find(key);
+   if (it == index.end() || it->second.type != BinaryTypeBlob) return {};
+   return std::string_view(it->second.data, it->second.size);
+}
@@ -0,0 +1,155 @@
+//
+// Created by Cristobal Mendoza.
+//
+
+#ifndef NERVOUSSTRUCTUREOF_MTBINARYSERIALIZER_HPP
+#define NERVOUSSTRUCTUREOF_MTBINARYSERIALIZER_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+class ofAbstractParameter;
+class ofParameterGroup;
+
+/// \brief The type tags of the values in a binary document.
+enum MTBinaryType : uint8_t
+{
+   BinaryTypeBool = 1,
+   BinaryTypeInt,
+   BinaryTypeFloat,
+   BinaryTypeDouble,
+   BinaryTypeVec2,
+   BinaryTypeVec3,
+   BinaryTypeVec4,
+   BinaryTypeFloatColor,
+   BinaryTypeColor,
+   // Anything else ofParameter can stringify:
+   BinaryTypeString,
+   // Raw bytes written by a model's own serialize():
+   BinaryTypeBlob,
+   // MTAppFramework::PathToPacked:
+   BinaryTypePath
+};
+
+/// \brief Writes the binary document format used by MTApp::BINARY.
+///
+/// A document is a 16 byte header ("MTBN", version, entry count), a table of
+/// the entries' keys, a directory with the type, size and offset of every
+/// entry, and finally the payloads, each aligned to 8 bytes. Parameters are
+/// keyed by their path in the group hierarchy ("Model/Group/Param") and stored
+/// as raw little-endian values: no text conversion for numbers, vectors, colors
+/// and paths. Every platform openFrameworks runs on is little-endian, so values
+/// are copied as they are in memory.
+class MTBinaryWriter
+{
+ public:
+   /// \brief Writes every parameter of the group and of its nested groups,
+   /// keyed by path. `prefix` is prepended to the paths.
+   void serialize(const ofParameterGroup& group, const std::string& prefix = "");
+
+   /// \brief Writes a single parameter under `key`. Groups are written
+   /// recursively.
+   void write(const std::string& key, const ofAbstractParameter& parameter);
+
+   /// \brief Writes raw bytes under `key`, for data that doesn't live in an
+   /// ofParameter.
+   void writeBlob(const std::string& key, const void* data, size_t size);
+
+   /// \brief The whole document.
+   std::string toString() const;
+
+   /// \brief Writes the document to disk, atomically.
+   bool save(const std::filesystem::path& path) const;
+
+   size_t getNumEntries() const
+   {
+      return entries.size();
+   }
+
+ private:
+   struct Entry
+   {
+      std::string key;
+      MTBinaryType type;
+      // Offset into payloads:
+      size_t offset;
+      size_t size;
+   };
+
+   std::vector<Entry> entries;
+   std::string payloads;
+
+   void append(const std::string& key, MTBinaryType type, const void* data, size_t size);
+};
+
+/// \brief Reads the binary document format, straight from a memory mapping of
+/// the file where the platform supports it. Looking an entry up doesn't copy
+/// its payload.
+class MTBinaryReader
+{
+ public:
+   MTBinaryReader();
+   ~MTBinaryReader();
+
+   MTBinaryReader(const MTBinaryReader&) = delete;
+   MTBinaryReader& operator=(const MTBinaryReader&) = delete;
+
+   /// \brief Maps the file and reads its tables.
+   /// \returns false if the file can't be read or isn't a valid document.
+   bool open(const std::filesystem::path& path);
+
+   /// \brief Reads a document from memory. The data is copied.
+   bool parse(std::string data);
+
+   bool isOpen() const
+   {
+      return hasDocument;
+   }
+
+   size_t getNumEntries() const
+   {
+      return index.size();
+   }
+
+   /// \brief Sets every parameter of the group, and of its nested groups, that
+   /// has an entry in the document. Parameters without an entry keep their
+   /// values.
+   void deserialize(ofParameterGroup& group, const std::string& prefix = "");
+
+   /// \brief Sets the parameter from the entry under `key`.
+   /// \returns false if there is no entry, or its type doesn't fit.
+   bool read(const std::string& key, ofAbstractParameter& parameter);
+
+   bool hasEntry(std::string_view key) const
+   {
+      return index.count(key) > 0;
+   }
+
+   /// \brief The bytes of a blob entry, or an empty view if there isn't one.
+   /// Valid as long as the reader is.
+   std::string_view readBlob(std::string_view key) const;
+
+ private:
+   struct Entry
+   {
+      MTBinaryType type;
+      const char* data;
+      size_t size;
+   };
+
+   struct MappedFile;
+   std::unique_ptr<MappedFile> file;
+   std::string ownedData;
+   bool hasDocument = false;
+   std::unordered_map<std::string_view, Entry> index;
+
+   bool readTables(const char* data, size_t size);
+};
+
+
+#endif  //NERVOUSSTRUCTUREOF_MTBINARYSERIALIZER_HPP
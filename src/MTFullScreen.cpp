@@ -141,7 +141,8 @@ void priv::enterFullScreen()
 
       auto fsView = MTView::CreateView<MTFullScreenView>(name, fsDisplay, outputTexture);
       window->setWindowPosition(frame.position.x, frame.position.y);
-      //		window->events().setFrameRate(frameRate);
+      window->setPriority(WindowPriorityOutput);
+      window->setTargetFrameRate(frameRate);
       //		window->setVerticalSync(false);
       fsView->setSize(window->getFrameSize());
       window->addSubview(std::move(fsView));
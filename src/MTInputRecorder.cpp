@@ -0,0 +1,328 @@
+//
+// Created by Cristobal Mendoza.
+//
+
+#include "MTInputRecorder.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include "MTWindow.hpp"
+#include "ofLog.h"
+
+namespace
+{
+const char RecordingMagic[4] = {'M', 'T', 'I', 'R'};
+const uint32_t RecordingVersion = 1;
+
+int64_t nowMicros()
+{
+   return std::chrono::duration_cast<std::chrono::microseconds>(
+              std::chrono::steady_clock::now().time_since_epoch())
+       .count();
+}
+
+// Little-endian regardless of the platform:
+void putU32(std::ostream& os, uint32_t v)
+{
+   char bytes[4] = {char(v), char(v >> 8), char(v >> 16), char(v >> 24)};
+   os.write(bytes, 4);
+}
+
+void putF32(std::ostream& os, float f)
+{
+   uint32_t v;
+   std::memcpy(&v, &f, 4);
+   putU32(os, v);
+}
+
+uint32_t getU32(std::istream& is)
+{
+   unsigned char bytes[4] = {0, 0, 0, 0};
+   is.read(reinterpret_cast<char*>(bytes), 4);
+   return uint32_t(bytes[0]) | uint32_t(bytes[1]) << 8 | uint32_t(bytes[2]) << 16 | uint32_t(bytes[3]) << 24;
+}
+
+float getF32(std::istream& is)
+{
+   uint32_t v = getU32(is);
+   float f;
+   std::memcpy(&f, &v, 4);
+   return f;
+}
+}
+
+#pragma mark MTInputRecording
+
+bool MTInputRecording::save(const std::filesystem::path& path) const
+{
+   std::ofstream os(path, std::ios::binary);
+   if (!os)
+   {
+      ofLogError("MTInputRecording") << "Could not open " << path << " for writing";
+      return false;
+   }
+
+   os.write(RecordingMagic, 4);
+   putU32(os, RecordingVersion);
+   putU32(os, events.size());
+   for (const auto& e : events)
+   {
+      putU32(os, e.frame);
+      putU32(os, e.time);
+      char header[4] = {char(e.kind), char(e.isRepeat), char(e.modifiers), char(e.modifiers >> 8)};
+      os.write(header, 4);
+      if (e.isMouseEvent())
+      {
+         putF32(os, e.x);
+         putF32(os, e.y);
+         putF32(os, e.scrollX);
+         putF32(os, e.scrollY);
+         putU32(os, e.button);
+      }
+      else
+      {
+         putU32(os, e.key);
+         putU32(os, e.keycode);
+         putU32(os, e.scancode);
+         putU32(os, e.codepoint);
+      }
+   }
+   return os.good();
+}
+
+bool MTInputRecording::load(const std::filesystem::path& path)
+{
+   std::ifstream is(path, std::ios::binary);
+   char magic[4];
+   if (!is.read(magic, 4) || std::memcmp(magic, RecordingMagic, 4) != 0)
+   {
+      ofLogError("MTInputRecording") << path << " is not an input recording";
+      return false;
+   }
+   auto version = getU32(is);
+   if (version != RecordingVersion)
+   {
+      ofLogError("MTInputRecording") << path << " has an unsupported version: " << version;
+      return false;
+   }
+
+   auto count = getU32(is);
+   std::vector<MTInputEvent> loaded;
+   loaded.reserve(std::min<uint32_t>(count, 1 << 20));
+   for (uint32_t i = 0; i < count && is; i++)
+   {
+      MTInputEvent e;
+      e.frame = getU32(is);
+      e.time = getU32(is);
+      unsigned char header[4];
+      is.read(reinterpret_cast<char*>(header), 4);
+      if (header[0] > MTInputEvent::KeyReleased) break;
+      e.kind = MTInputEvent::Kind(header[0]);
+      e.isRepeat = header[1] != 0;
+      e.modifiers = header[2] | header[3] << 8;
+      if (e.isMouseEvent())
+      {
+         e.x = getF32(is);
+         e.y = getF32(is);
+         e.scrollX = getF32(is);
+         e.scrollY = getF32(is);
+         e.button = getU32(is);
+      }
+      else
+      {
+         e.key = getU32(is);
+         e.keycode = getU32(is);
+         e.scancode = getU32(is);
+         e.codepoint = getU32(is);
+      }
+      if (is) loaded.push_back(e);
+   }
+
+   if (loaded.size() != count)
+   {
+      ofLogError("MTInputRecording") << path << " is truncated or corrupt";
+      return false;
+   }
+   events = std::move(loaded);
+   return true;
+}
+
+#pragma mark MTInputRecorder
+
+void MTInputRecorder::start(std::shared_ptr<MTWindow> window)
+{
+   stop();
+   this->window = window;
+   inputRecording.events.clear();
+   startFrame = window->events().getFrameNum();
+   startTime = nowMicros();
+   recording = true;
+
+   // Before the app, so that events consumed by a handler are recorded too:
+   auto& ev = window->events();
+   auto mouse = [this](ofMouseEventArgs& args) { recordMouse(args); };
+   auto key = [this](ofKeyEventArgs& args) { recordKey(args); };
+   listeners.push(ev.mousePressed.newListener(mouse, OF_EVENT_ORDER_BEFORE_APP));
+   listeners.push(ev.mouseMoved.newListener(mouse, OF_EVENT_ORDER_BEFORE_APP));
+   listeners.push(ev.mouseReleased.newListener(mouse, OF_EVENT_ORDER_BEFORE_APP));
+   listeners.push(ev.mouseDragged.newListener(mouse, OF_EVENT_ORDER_BEFORE_APP));
+   listeners.push(ev.mouseScrolled.newListener(mouse, OF_EVENT_ORDER_BEFORE_APP));
+   listeners.push(ev.mouseEntered.newListener(mouse, OF_EVENT_ORDER_BEFORE_APP));
+   listeners.push(ev.mouseExited.newListener(mouse, OF_EVENT_ORDER_BEFORE_APP));
+   listeners.push(ev.keyPressed.newListener(key, OF_EVENT_ORDER_BEFORE_APP));
+   listeners.push(ev.keyReleased.newListener(key, OF_EVENT_ORDER_BEFORE_APP));
+}
+
+void MTInputRecorder::stop()
+{
+   listeners.unsubscribeAll();
+   recording = false;
+}
+
+void MTInputRecorder::record(MTInputEvent& e)
+{
+   auto w = window.lock();
+   if (!w) return;
+   e.frame = w->events().getFrameNum() - startFrame;
+   e.time = nowMicros() - startTime;
+   inputRecording.events.push_back(e);
+}
+
+void MTInputRecorder::recordMouse(const ofMouseEventArgs& args)
+{
+   MTInputEvent e;
+   e.kind = MTInputEvent::Kind(MTInputEvent::MousePressed + args.type);
+   e.modifiers = args.modifiers;
+   e.x = args.x;
+   e.y = args.y;
+   e.scrollX = args.scrollX;
+   e.scrollY = args.scrollY;
+   e.button = args.button;
+   record(e);
+}
+
+void MTInputRecorder::recordKey(const ofKeyEventArgs& args)
+{
+   MTInputEvent e;
+   e.kind = MTInputEvent::Kind(MTInputEvent::KeyPressed + args.type);
+   e.modifiers = args.modifiers;
+   e.key = args.key;
+   e.keycode = args.keycode;
+   e.scancode = args.scancode;
+   e.codepoint = args.codepoint;
+   e.isRepeat = args.isRepeat;
+   record(e);
+}
+
+#pragma mark MTInputPlayer
+
+void MTInputPlayer::play(std::shared_ptr<MTWindow> window, MTInputRecording recording, MTInputPlaybackMode mode)
+{
+   stop();
+   this->window = window;
+   this->mode = mode;
+   inputRecording = std::move(recording);
+   nextEvent = 0;
+   latencies.clear();
+   latencies.reserve(inputRecording.events.size());
+   hasStarted = false;
+   playing = true;
+
+   // Before the app, like real input, which arrives before the next update:
+   updateListener = window->events().update.newListener([this](ofEventArgs&) { update(); },
+                                                        OF_EVENT_ORDER_BEFORE_APP);
+}
+
+void MTInputPlayer::stop()
+{
+   updateListener.unsubscribe();
+   playing = false;
+}
+
+void MTInputPlayer::update()
+{
+   auto w = window.lock();
+   if (!w)
+   {
+      stop();
+      return;
+   }
+
+   if (!hasStarted)
+   {
+      hasStarted = true;
+      startFrame = w->events().getFrameNum();
+      startTime = nowMicros();
+   }
+
+   auto frame = w->events().getFrameNum() - startFrame;
+   auto time = nowMicros() - startTime;
+   auto& events = inputRecording.events;
+   while (nextEvent < events.size())
+   {
+      auto& e = events[nextEvent];
+      bool isDue = mode == PlaybackFrames ? e.frame <= frame : e.time <= time;
+      if (!isDue) break;
+      dispatch(e, *w);
+      nextEvent++;
+   }
+
+   if (nextEvent == events.size())
+   {
+      stop();
+      auto report = getLatencyReport();
+      ofNotifyEvent(playbackFinishedEvent, report, this);
+   }
+}
+
+void MTInputPlayer::dispatch(const MTInputEvent& e, MTWindow& w)
+{
+   auto start = std::chrono::steady_clock::now();
+   if (e.isMouseEvent())
+   {
+      ofMouseEventArgs args(ofMouseEventArgs::Type(e.kind - MTInputEvent::MousePressed),
+                            e.x,
+                            e.y,
+                            e.button,
+                            e.modifiers);
+      args.scrollX = e.scrollX;
+      args.scrollY = e.scrollY;
+      w.events().notifyMouseEvent(args);
+   }
+   else
+   {
+      ofKeyEventArgs args(ofKeyEventArgs::Type(e.kind - MTInputEvent::KeyPressed),
+                          e.key,
+                          e.keycode,
+                          e.scancode,
+                          e.codepoint,
+                          e.modifiers);
+      args.isRepeat = e.isRepeat;
+      w.events().notifyKeyEvent(args);
+   }
+   auto elapsed = std::chrono::steady_clock::now() - start;
+   latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
+MTInputPlayer::LatencyReport MTInputPlayer::getLatencyReport() const
+{
+   LatencyReport report;
+   report.count = latencies.size();
+   if (latencies.empty()) return report;
+
+   auto sorted = latencies;
+   std::sort(sorted.begin(), sorted.end());
+   // Nearest rank, in microseconds:
+   auto percentile = [&](double p)
+   {
+      size_t rank = std::ceil(p * sorted.size());
+      return sorted[std::max<size_t>(rank, 1) - 1] * 1e-3;
+   };
+   report.p50 = percentile(0.5);
+   report.p90 = percentile(0.9);
+   report.p99 = percentile(0.99);
+   report.max = sorted.back() * 1e-3;
+   return report;
+}
@@ -0,0 +1,170 @@
+//
+// Created by Cristobal Mendoza.
+//
+
+#ifndef NERVOUSSTRUCTUREOF_MTINPUTRECORDER_HPP
+#define NERVOUSSTRUCTUREOF_MTINPUTRECORDER_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <vector>
+#include "ofEvent.h"
+#include "ofEvents.h"
+
+class MTWindow;
+
+/// \brief A mouse or key event as an MTWindow received it.
+struct MTInputEvent
+{
+   /// The mouse kinds are in the order of ofMouseEventArgs::Type:
+   enum Kind : uint8_t
+   {
+      MousePressed = 0,
+      MouseMoved,
+      MouseReleased,
+      MouseDragged,
+      MouseScrolled,
+      MouseEntered,
+      MouseExited,
+      KeyPressed,
+      KeyReleased
+   };
+
+   /// \brief Frames since the recording started.
+   uint32_t frame = 0;
+   /// \brief Microseconds since the recording started. Wraps around after
+   /// about 71 minutes.
+   uint32_t time = 0;
+   Kind kind = MouseMoved;
+   uint16_t modifiers = 0;
+
+   // Mouse events:
+   float x = 0;
+   float y = 0;
+   float scrollX = 0;
+   float scrollY = 0;
+   int32_t button = 0;
+
+   // Key events:
+   int32_t key = 0;
+   int32_t keycode = 0;
+   int32_t scancode = 0;
+   uint32_t codepoint = 0;
+   bool isRepeat = false;
+
+   bool isMouseEvent() const
+   {
+      return kind < KeyPressed;
+   }
+};
+
+/// \brief A sequence of input events, which can be stored in a compact
+/// binary file: a header followed by one record per event, 12 bytes plus 20
+/// for mouse events or 16 for key events, little-endian.
+struct MTInputRecording
+{
+   std::vector<MTInputEvent> events;
+
+   /// \returns false if the file couldn't be written.
+   bool save(const std::filesystem::path& path) const;
+
+   /// \returns false if the file couldn't be read or isn't a recording.
+   bool load(const std::filesystem::path& path);
+};
+
+/// \brief Records the mouse and key events that a window dispatches, with the
+/// frame on which they arrived. Motion is recorded as the window dispatches
+/// it, so with motion coalescing on there is at most one move per frame.
+class MTInputRecorder
+{
+ public:
+   /// \brief Clears the recording and starts recording the window's input.
+   void start(std::shared_ptr<MTWindow> window);
+   void stop();
+
+   bool isRecording() const
+   {
+      return recording;
+   }
+
+   const MTInputRecording& getRecording() const
+   {
+      return inputRecording;
+   }
+
+ private:
+   ofEventListeners listeners;
+   std::weak_ptr<MTWindow> window;
+   MTInputRecording inputRecording;
+   bool recording = false;
+   uint64_t startFrame = 0;
+   int64_t startTime = 0;
+
+   void record(MTInputEvent& e);
+   void recordMouse(const ofMouseEventArgs& args);
+   void recordKey(const ofKeyEventArgs& args);
+};
+
+enum MTInputPlaybackMode
+{
+   /// Every event is dispatched on the same frame, relative to the start, as it
+   /// was recorded. Playback runs as fast as the window does, so on an
+   /// unthrottled MTOffscreenWindow it runs at full speed and is deterministic.
+   PlaybackFrames = 0,
+   /// Events are dispatched when as much real time has passed as when they
+   /// were recorded.
+   PlaybackRealTime
+};
+
+/// \brief Plays a recording back into a window through its event dispatch,
+/// the same way real input reaches the window's handlers, and measures how
+/// long each event takes to dispatch.
+class MTInputPlayer
+{
+ public:
+   /// \brief Dispatch latencies, in microseconds.
+   struct LatencyReport
+   {
+      size_t count = 0;
+      double p50 = 0;
+      double p90 = 0;
+      double p99 = 0;
+      double max = 0;
+   };
+
+   /// \brief Starts playing the recording on the window's next update.
+   void play(std::shared_ptr<MTWindow> window,
+             MTInputRecording recording,
+             MTInputPlaybackMode mode = PlaybackFrames);
+   void stop();
+
+   bool isPlaying() const
+   {
+      return playing;
+   }
+
+   /// \brief The latencies of the events dispatched so far.
+   LatencyReport getLatencyReport() const;
+
+   /// \brief Notified after the last event of the recording was dispatched.
+   ofEvent<LatencyReport> playbackFinishedEvent;
+
+ private:
+   ofEventListener updateListener;
+   std::weak_ptr<MTWindow> window;
+   MTInputRecording inputRecording;
+   MTInputPlaybackMode mode = PlaybackFrames;
+   bool playing = false;
+   bool hasStarted = false;
+   size_t nextEvent = 0;
+   uint64_t startFrame = 0;
+   int64_t startTime = 0;
+   std::vector<int64_t> latencies;
+
+   void update();
+   void dispatch(const MTInputEvent& e, MTWindow& w);
+};
+
+
+#endif  //NERVOUSSTRUCTUREOF_MTINPUTRECORDER_HPP
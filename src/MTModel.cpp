@@ -8,11 +8,20 @@
 
 #include "MTModel.hpp"
 #include "ofXml.h"
+#include "MTBinarySerializer.hpp"
+#include "MTStreamingReader.hpp"
 
 MTModel::MTModel(std::string _name)
 {
    name = _name;
    parameters.setName(name);
+   // Changes in nested groups are notified on their parents too:
+   addEventListener(parameters.parameterChangedE().newListener(
+       [this](ofAbstractParameter& parameter)
+       {
+          std::lock_guard<std::mutex> lock(changedParametersMutex);
+          changedParameters.insert(parameter.getInternalObject());
+       }));
 }
 
 std::string MTModel::getName()
@@ -51,8 +60,60 @@ void MTModel::deserialize(ofJson& serializer)
    ofDeserialize(serializer, parameters);
 }
 
+void MTModel::serialize(MTBinaryWriter& serializer)
+{
+   serializer.serialize(parameters, parameters.getEscapedName());
+}
+
+void MTModel::deserialize(MTBinaryReader& serializer)
+{
+   serializer.deserialize(parameters, parameters.getEscapedName());
+}
+
+void MTModel::deserialize(MTStreamingReader& reader)
+{
+   reader.deserialize(parameters);
+}
+
 void MTModel::addChildModel(std::shared_ptr<MTModel> childModel)
 {
    children.push_back(childModel);
    parameters.add(childModel->getParameters());
+   setNeedsFullSave();
+}
+
+bool MTModel::hasUnsavedChanges()
+{
+   std::lock_guard<std::mutex> lock(changedParametersMutex);
+   return needsFullSave || !changedParameters.empty();
+}
+
+void MTModel::markSaved()
+{
+   std::lock_guard<std::mutex> lock(changedParametersMutex);
+   changedParameters.clear();
+   needsFullSave = false;
+}
+
+void MTModel::serializeChanges(MTBinaryWriter& serializer)
+{
+   std::lock_guard<std::mutex> lock(changedParametersMutex);
+   if (changedParameters.empty()) return;
+   serializeChanges(parameters, parameters.getEscapedName(), serializer);
+}
+
+void MTModel::serializeChanges(const ofParameterGroup& group, const std::string& prefix, MTBinaryWriter& serializer)
+{
+   for (const auto& parameter : group)
+   {
+      auto key = prefix + "/" + parameter->getEscapedName();
+      if (auto childGroup = dynamic_cast<const ofParameterGroup*>(parameter.get()))
+      {
+         serializeChanges(*childGroup, key, serializer);
+      }
+      else if (changedParameters.count(parameter->getInternalObject()) > 0)
+      {
+         serializer.write(key, *parameter);
+      }
+   }
 }
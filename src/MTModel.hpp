@@ -9,11 +9,16 @@
 #ifndef ofxMTModel_hpp
 #define ofxMTModel_hpp
 
+#include <mutex>
+#include <unordered_set>
 #include "MTAppFrameworkUtils.hpp"
 #include "ofJson.h"
 
 class ofXml;
 class ofParameterGroup;
+class MTBinaryWriter;
+class MTBinaryReader;
+class MTStreamingReader;
 
 class MTModel : public MTEventListenerStore
 {
@@ -37,6 +42,12 @@ class MTModel : public MTEventListenerStore
 	 */
    virtual void serialize(ofXml& serializer);
    virtual void serialize(ofJson& serializer);
+   /**
+	 * @brief Writes every parameter of the Model, including nested groups, into
+	 * a binary document, keyed by its path. Override this to store data that
+	 * doesn't live in ofParameters, with MTBinaryWriter::writeBlob.
+	 */
+   virtual void serialize(MTBinaryWriter& serializer);
    /**
 	 * @brief Deserializes the ofParameterGroup of the Model. Override this method
 	 * if you need to deserialize data that the ofParameter system can't handle on
@@ -47,6 +58,21 @@ class MTModel : public MTEventListenerStore
 	 */
    virtual void deserialize(ofXml& serializer);
    virtual void deserialize(ofJson& json);
+   /**
+	 * @brief Sets every parameter of the Model, including nested groups, that
+	 * the binary document has a value for. Also used to replay the entries of
+	 * a journal (see MTApp::setJournaledSaves), which only hold the
+	 * parameters that changed.
+	 */
+   virtual void deserialize(MTBinaryReader& serializer);
+   /**
+	 * @brief Sets the parameters of the Model while the XML or JSON document is
+	 * read, without loading it into memory first (see
+	 * MTApp::setStreamingOpen). Override this to read data that doesn't live
+	 * in ofParameters, by passing MTStreamingReader::deserialize a handler for
+	 * the values that don't match a parameter.
+	 */
+   virtual void deserialize(MTStreamingReader& reader);
 
    void addChildModel(std::shared_ptr<MTModel> childModel);
 
@@ -72,12 +98,56 @@ class MTModel : public MTEventListenerStore
    {
    }
 
+#pragma mark Change Tracking
+
+   /**
+	 * @brief True if any parameter of the Model changed since the last call
+	 * to markSaved(), or if setNeedsFullSave() was called.
+	 */
+   bool hasUnsavedChanges();
+
+   /**
+	 * @brief Forgets the changes recorded so far. MTApp calls this after the
+	 * Model was loaded or saved.
+	 */
+   void markSaved();
+
+   /**
+	 * @brief Only changes to parameter values are tracked. Call this after
+	 * changing anything else that the Model serializes (the parameters
+	 * themselves, or data written by an overridden serialize()), so that the
+	 * next save writes the whole document instead of a journal entry.
+	 */
+   void setNeedsFullSave()
+   {
+      needsFullSave = true;
+   }
+
+   bool getNeedsFullSave() const
+   {
+      return needsFullSave;
+   }
+
+   /**
+	 * @brief Writes only the parameters that changed since the last
+	 * markSaved(), with the same keys that serialize(MTBinaryWriter&) uses.
+	 */
+   void serializeChanges(MTBinaryWriter& serializer);
+
  protected:
    ofParameterGroup parameters;
 
  private:
    std::string name;
    std::vector<std::shared_ptr<MTModel>> children;
+
+   // The internal objects of the parameters that changed. Parameters can be
+   // set from any thread, hence the mutex:
+   std::unordered_set<const void*> changedParameters;
+   std::mutex changedParametersMutex;
+   bool needsFullSave = false;
+
+   void serializeChanges(const ofParameterGroup& group, const std::string& prefix, MTBinaryWriter& serializer);
 };
 
 #endif /* ofxMTModel_hpp */
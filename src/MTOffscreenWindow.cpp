@@ -0,0 +1,141 @@
+//
+// Created by Cristobal Mendoza.
+//
+
+#include "MTOffscreenWindow.hpp"
+
+#ifndef TARGET_RASPBERRY_PI
+
+#include "GLFW/glfw3.h"
+#include "MTProfiler.hpp"
+#include "ofAppRunner.h"
+#include "ofGraphics.h"
+#include "ofMainLoop.h"
+
+MTOffscreenWindow::MTOffscreenWindow(const std::string& name) : MTWindow(name)
+{
+   // Everything is drawn into the FBO:
+   isWindowTargetFlipped = false;
+}
+
+void MTOffscreenWindow::setup(ofGLFWWindowSettings& settings)
+{
+   settings.visible = false;
+   // Multisampling isn't guaranteed to resolve the same way on every driver:
+   settings.numSamples = 0;
+   MTWindow::setup(settings);
+   setVerticalSync(false);
+   allocateFbo();
+   applyTiming();
+}
+
+void MTOffscreenWindow::setTimestep(double seconds)
+{
+   if (seconds <= 0)
+   {
+      ofLogError("MTOffscreenWindow") << "setTimestep: the timestep must be positive";
+      return;
+   }
+   timestep = seconds;
+   applyTiming();
+}
+
+void MTOffscreenWindow::setUnthrottled(bool unthrottled)
+{
+   this->unthrottled = unthrottled;
+   applyTiming();
+}
+
+void MTOffscreenWindow::applyTiming()
+{
+   events().setTimeModeFixedRate(ofGetFixedStepForFps(1.0 / timestep));
+   events().setFrameRate(unthrottled ? 0 : std::round(1.0 / timestep));
+}
+
+uint64_t MTOffscreenWindow::getFrameNum()
+{
+   return events().getFrameNum();
+}
+
+double MTOffscreenWindow::getTime()
+{
+   return getFrameNum() * timestep;
+}
+
+void MTOffscreenWindow::renderFrames(int count)
+{
+   // ofGetWidth(), ofGetCurrentRenderer() and the timing functions all go
+   // through the main loop's current window, so this one has to be current
+   // for the output to only depend on the frame number:
+   auto mainLoop = ofGetMainLoop();
+   auto previousWindow = mainLoop->getCurrentWindow();
+   auto previousContext = glfwGetCurrentContext();
+
+   // The frame timer only waits when the window is throttled:
+   for (int i = 0; i < count; i++)
+   {
+      mainLoop->setCurrentWindow(this);
+      makeCurrent();
+      update();
+      draw();
+   }
+
+   if (previousWindow) mainLoop->setCurrentWindow(previousWindow);
+   glfwMakeContextCurrent(previousContext);
+}
+
+void MTOffscreenWindow::update()
+{
+   // No pacing, hidden windows are otherwise paused:
+   ofAppGLFWWindow::update();
+}
+
+void MTOffscreenWindow::draw()
+{
+   MT_PROFILE_SCOPE_LABEL("MTOffscreenWindow::draw", name.get());
+   if (fbo.getWidth() != ofAppGLFWWindow::getWidth() || fbo.getHeight() != ofAppGLFWWindow::getHeight())
+   {
+      allocateFbo();
+   }
+
+   // Like ofAppGLFWWindow::draw(), minus showing anything:
+   auto& r = renderer();
+   r->startRender();
+   fbo.begin();
+   events().notifyDraw();
+   fbo.end();
+   r->finishRender();
+}
+
+void MTOffscreenWindow::allocateFbo()
+{
+   ofFboSettings settings;
+   settings.width = std::max(ofAppGLFWWindow::getWidth(), 1);
+   settings.height = std::max(ofAppGLFWWindow::getHeight(), 1);
+   settings.internalformat = GL_RGBA;
+   settings.numSamples = 0;
+   settings.useDepth = true;
+   settings.useStencil = true;
+   fbo.allocate(settings);
+}
+
+void MTOffscreenWindow::readPixels(ofPixels& pixels) const
+{
+   fbo.readToPixels(pixels);
+}
+
+uint64_t MTOffscreenWindow::hashPixels() const
+{
+   ofPixels pixels;
+   readPixels(pixels);
+   uint64_t hash = 14695981039346656037ull;
+   auto data = pixels.getData();
+   for (size_t i = 0; i < pixels.getTotalBytes(); i++)
+   {
+      hash ^= data[i];
+      hash *= 1099511628211ull;
+   }
+   return hash;
+}
+
+#endif
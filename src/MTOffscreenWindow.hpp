@@ -0,0 +1,89 @@
+//
+// Created by Cristobal Mendoza.
+//
+
+#ifndef NERVOUSSTRUCTUREOF_MTOFFSCREENWINDOW_HPP
+#define NERVOUSSTRUCTUREOF_MTOFFSCREENWINDOW_HPP
+
+#ifndef TARGET_RASPBERRY_PI
+
+#include "MTWindow.hpp"
+#include "ofFbo.h"
+#include "ofPixels.h"
+
+/// \brief A hidden window that draws its views into an FBO instead of the
+/// screen, for batch rendering and for running on machines without a display
+/// (a software GL such as Mesa's llvmpipe under Xvfb works).
+///
+/// The window goes through the same update and draw pipeline as any other
+/// MTWindow, but it never swaps buffers and ignores frame pacing and the redraw
+/// policy: every frame is drawn. Time advances by a fixed step per frame, so
+/// ofGetElapsedTimef() and ofGetLastFrameTime() seen by its views only depend
+/// on the frame number, and the output of a frame can be compared across runs
+/// with hashPixels().
+///
+/// Create it with MTApp::createOffscreenWindow(). It is driven by the main loop
+/// like the other windows, or synchronously with renderFrames().
+class MTOffscreenWindow : public MTWindow
+{
+ public:
+   MTOffscreenWindow(const std::string& name);
+
+   void setup(ofGLFWWindowSettings& settings) override;
+
+   /// \brief The simulated time between two frames. Defaults to 1/60 s.
+   void setTimestep(double seconds);
+
+   double getTimestep() const
+   {
+      return timestep;
+   }
+
+   /// \brief When true, the window doesn't wait for the next frame and runs as
+   /// fast as the main loop allows. Otherwise it runs at 1 / timestep frames
+   /// per second of real time. Simulated time is the same either way.
+   void setUnthrottled(bool unthrottled);
+
+   bool isUnthrottled() const
+   {
+      return unthrottled;
+   }
+
+   /// \brief Runs `count` frames right away, without going through the main
+   /// loop. The window and GL context that were current before are restored
+   /// afterwards.
+   void renderFrames(int count = 1);
+
+   uint64_t getFrameNum();
+
+   /// \brief The simulated time of the current frame, in seconds.
+   double getTime();
+
+   const ofFbo& getFbo() const
+   {
+      return fbo;
+   }
+
+   /// \brief Reads back the last frame.
+   void readPixels(ofPixels& pixels) const;
+
+   /// \brief A 64 bit FNV-1a hash of the pixels of the last frame.
+   uint64_t hashPixels() const;
+
+   using MTWindow::update;
+   using MTWindow::draw;
+   void update() override;
+   void draw() override;
+
+ private:
+   ofFbo fbo;
+   double timestep = 1.0 / 60.0;
+   bool unthrottled = false;
+
+   void allocateFbo();
+   void applyTiming();
+};
+
+#endif
+
+#endif  //NERVOUSSTRUCTUREOF_MTOFFSCREENWINDOW_HPP
@@ -0,0 +1,338 @@
+//
+// Created by Cristobal Mendoza.
+//
+
+#ifndef NERVOUSSTRUCTUREOF_MTOPERATIONQUEUE_HPP
+#define NERVOUSSTRUCTUREOF_MTOPERATIONQUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/// \brief A move-only `void()` callable with a small inline buffer.
+///
+/// Callables that fit in the buffer (most lambdas capturing a few pointers or
+/// a shared_ptr, and std::function itself) are stored inline, so wrapping them
+/// doesn't allocate. Larger callables are moved to the heap.
+class MTOperation
+{
+ public:
+   MTOperation() = default;
+
+   template<typename F,
+            typename = typename std::enable_if<!std::is_same<typename std::decay<F>::type, MTOperation>::value>::type>
+   MTOperation(F&& f)
+   {
+      using T = typename std::decay<F>::type;
+      if constexpr (IsInline<T>::value)
+      {
+         new (buffer) T(std::forward<F>(f));
+         ops = &InlineOps<T>::ops;
+      }
+      else
+      {
+         *reinterpret_cast<T**>(buffer) = new T(std::forward<F>(f));
+         ops = &HeapOps<T>::ops;
+      }
+   }
+
+   MTOperation(MTOperation&& other) noexcept
+   {
+      moveFrom(other);
+   }
+
+   MTOperation& operator=(MTOperation&& other) noexcept
+   {
+      if (this != &other)
+      {
+         reset();
+         moveFrom(other);
+      }
+      return *this;
+   }
+
+   MTOperation(const MTOperation&) = delete;
+   MTOperation& operator=(const MTOperation&) = delete;
+
+   ~MTOperation()
+   {
+      reset();
+   }
+
+   void operator()()
+   {
+      ops->invoke(buffer);
+   }
+
+   explicit operator bool() const
+   {
+      return ops != nullptr;
+   }
+
+   void reset()
+   {
+      if (ops)
+      {
+         ops->destroy(buffer);
+         ops = nullptr;
+      }
+   }
+
+ private:
+   // Large enough for a std::function in both libstdc++ and libc++:
+   static constexpr size_t BufferSize = 48;
+
+   struct Ops
+   {
+      void (*invoke)(void*);
+      void (*move)(void* dst, void* src);
+      void (*destroy)(void*);
+   };
+
+   template<typename T>
+   struct IsInline
+   {
+      static constexpr bool value = sizeof(T) <= BufferSize && alignof(T) <= alignof(void*) &&
+                                    std::is_nothrow_move_constructible<T>::value;
+   };
+
+   template<typename T>
+   struct InlineOps
+   {
+      static void invoke(void* p)
+      {
+         (*static_cast<T*>(p))();
+      }
+      static void move(void* dst, void* src)
+      {
+         new (dst) T(std::move(*static_cast<T*>(src)));
+         static_cast<T*>(src)->~T();
+      }
+      static void destroy(void* p)
+      {
+         static_cast<T*>(p)->~T();
+      }
+      static constexpr Ops ops = {&invoke, &move, &destroy};
+   };
+
+   template<typename T>
+   struct HeapOps
+   {
+      static void invoke(void* p)
+      {
+         (**static_cast<T**>(p))();
+      }
+      static void move(void* dst, void* src)
+      {
+         *static_cast<T**>(dst) = *static_cast<T**>(src);
+      }
+      static void destroy(void* p)
+      {
+         delete *static_cast<T**>(p);
+      }
+      static constexpr Ops ops = {&invoke, &move, &destroy};
+   };
+
+   void moveFrom(MTOperation& other)
+   {
+      ops = other.ops;
+      if (ops)
+      {
+         ops->move(buffer, other.buffer);
+         other.ops = nullptr;
+      }
+   }
+
+   alignas(void*) unsigned char buffer[BufferSize];
+   const Ops* ops = nullptr;
+};
+
+/// \brief A lock-free multi-producer, single-consumer queue of MTOperations.
+///
+/// Any thread may call enqueue(). Only one thread, the one that owns the queue
+/// (normally the main thread), may call drain() or empty(). Operations run in
+/// the order in which they were enqueued.
+///
+/// This is Dmitry Vyukov's intrusive MPSC queue. Enqueueing is a single atomic
+/// exchange and never blocks. Queue nodes are recycled through a shared pool,
+/// so in steady state enqueueing doesn't allocate either.
+class MTOperationQueue
+{
+ public:
+   /// \brief The default maximum number of operations that drain() runs per
+   /// call. Keeps a burst of operations from stalling a frame; whatever is left
+   /// runs on the next drain.
+   static inline size_t DefaultDrainLimit = 4096;
+
+   MTOperationQueue() : head(&stub), tail(&stub)
+   {
+   }
+
+   ~MTOperationQueue()
+   {
+      while (auto node = pop())
+      {
+         releaseNode(node);
+      }
+   }
+
+   MTOperationQueue(const MTOperationQueue&) = delete;
+   MTOperationQueue& operator=(const MTOperationQueue&) = delete;
+
+   /// \brief Adds an operation to the queue. Safe to call from any thread.
+   void enqueue(MTOperation&& op)
+   {
+      auto node = allocateNode();
+      node->op = std::move(op);
+      push(node);
+   }
+
+   /// \brief Runs up to `maxOperations` of the queued operations, in FIFO order.
+   /// Operations enqueued while draining (even by the operations themselves) may
+   /// run in the same call. Consumer thread only.
+   /// \returns The number of operations that were run.
+   size_t drain(size_t maxOperations = DefaultDrainLimit)
+   {
+      size_t count = 0;
+      while (count < maxOperations)
+      {
+         auto node = pop();
+         if (!node) break;
+         // Take the operation out first, so that it can recycle its node:
+         auto op = std::move(node->op);
+         releaseNode(node);
+         op();
+         count++;
+      }
+      return count;
+   }
+
+   /// \brief Consumer thread only. May return true while a producer is halfway
+   /// through an enqueue, so treat it as a hint.
+   bool empty() const
+   {
+      return tail == &stub && stub.next.load(std::memory_order_acquire) == nullptr;
+   }
+
+ private:
+   struct Node
+   {
+      std::atomic<Node*> next{nullptr};
+      MTOperation op;
+   };
+
+   std::atomic<Node*> head;  // Producers push here
+   Node* tail;  // The consumer pops here
+   Node stub;
+
+   void push(Node* node)
+   {
+      node->next.store(nullptr, std::memory_order_relaxed);
+      auto prev = head.exchange(node, std::memory_order_acq_rel);
+      prev->next.store(node, std::memory_order_release);
+   }
+
+   Node* pop()
+   {
+      auto t = tail;
+      auto next = t->next.load(std::memory_order_acquire);
+      if (t == &stub)
+      {
+         if (!next) return nullptr;
+         tail = next;
+         t = next;
+         next = next->next.load(std::memory_order_acquire);
+      }
+
+      if (next)
+      {
+         tail = next;
+         return t;
+      }
+
+      // t is the last node. If a producer is in the middle of a push we can't
+      // take it yet, it will be there on the next drain:
+      if (t != head.load(std::memory_order_acquire)) return nullptr;
+
+      push(&stub);
+      next = t->next.load(std::memory_order_acquire);
+      if (next)
+      {
+         tail = next;
+         return t;
+      }
+      return nullptr;
+   }
+
+   // Node pool. Released nodes go into a shared lock-free stack. Each thread
+   // takes the whole stack at once into a cache of its own, which avoids the ABA
+   // problem of popping single nodes from a shared stack.
+   struct NodePool
+   {
+      std::atomic<Node*> freeList{nullptr};
+
+      ~NodePool()
+      {
+         deleteList(freeList.exchange(nullptr));
+      }
+   };
+
+   struct NodeCache
+   {
+      Node* head = nullptr;
+
+      ~NodeCache()
+      {
+         deleteList(head);
+      }
+   };
+
+   static NodePool& pool()
+   {
+      static NodePool p;
+      return p;
+   }
+
+   static void deleteList(Node* node)
+   {
+      while (node)
+      {
+         auto next = node->next.load(std::memory_order_relaxed);
+         delete node;
+         node = next;
+      }
+   }
+
+   static Node* allocateNode()
+   {
+      thread_local NodeCache cache;
+      if (!cache.head)
+      {
+         cache.head = pool().freeList.exchange(nullptr, std::memory_order_acquire);
+      }
+      if (cache.head)
+      {
+         auto node = cache.head;
+         cache.head = node->next.load(std::memory_order_relaxed);
+         return node;
+      }
+      return new Node();
+   }
+
+   static void releaseNode(Node* node)
+   {
+      node->op.reset();
+      auto& freeList = pool().freeList;
+      auto top = freeList.load(std::memory_order_relaxed);
+      do
+      {
+         node->next.store(top, std::memory_order_relaxed);
+      } while (!freeList.compare_exchange_weak(top, node, std::memory_order_release, std::memory_order_relaxed));
+   }
+};
+
+
+#endif  //NERVOUSSTRUCTUREOF_MTOPERATIONQUEUE_HPP
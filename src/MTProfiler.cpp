@@ -0,0 +1,323 @@
+//
+// Created by Cristobal Mendoza.
+//
+
+#include "MTProfiler.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include "ofLog.h"
+#include "ofUtils.h"
+#include "ofxImGui.h"
+
+namespace
+{
+struct ThreadBuffer
+{
+   std::vector<MTProfiler::Event> events;
+   // The number of events ever written. Only the owning thread writes it:
+   std::atomic<uint64_t> count{0};
+   uint32_t threadId = 0;
+   uint32_t depth = 0;
+};
+
+struct Registry
+{
+   std::mutex mutex;
+   // Buffers are kept after their thread exits, so that they can be exported:
+   std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+   std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+   // Frame boundaries, only written by the main thread:
+   std::array<int64_t, 256> frameMarks{};
+   std::atomic<uint64_t> frameCount{0};
+};
+
+Registry& registry()
+{
+   static Registry r;
+   return r;
+}
+
+ThreadBuffer& localBuffer()
+{
+   thread_local std::shared_ptr<ThreadBuffer> buffer;
+   if (!buffer)
+   {
+      buffer = std::make_shared<ThreadBuffer>();
+      buffer->events.resize(std::max<size_t>(MTProfiler::BufferCapacity, 1));
+      auto& r = registry();
+      std::lock_guard<std::mutex> lock(r.mutex);
+      buffer->threadId = r.buffers.size();
+      r.buffers.push_back(buffer);
+   }
+   return *buffer;
+}
+
+void writeJsonString(std::ostream& os, const char* s)
+{
+   os << '"';
+   for (; *s; s++)
+   {
+      switch (*s)
+      {
+      case '"': os << "\\\""; break;
+      case '\\': os << "\\\\"; break;
+      case '\n': os << "\\n"; break;
+      case '\t': os << "\\t"; break;
+      default:
+         if ((unsigned char) *s < 0x20) continue;
+         os << *s;
+      }
+   }
+   os << '"';
+}
+}
+
+int64_t MTProfiler::now()
+{
+   return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - registry().epoch)
+       .count();
+}
+
+void MTProfiler::Scope::begin(const char* name, const std::string* label)
+{
+   this->name = name;
+   this->label = label;
+   localBuffer().depth++;
+   start = now();
+}
+
+void MTProfiler::Scope::end()
+{
+   int64_t duration = now() - start;
+   auto& buffer = localBuffer();
+   buffer.depth--;
+
+   auto n = buffer.count.load(std::memory_order_relaxed);
+   auto& e = buffer.events[n % buffer.events.size()];
+   e.name = name;
+   e.start = start;
+   e.duration = duration;
+   e.depth = buffer.depth;
+   e.threadId = buffer.threadId;
+   e.label[0] = '\0';
+   if (label)
+   {
+      auto length = std::min(label->size(), sizeof(e.label) - 1);
+      std::memcpy(e.label, label->data(), length);
+      e.label[length] = '\0';
+   }
+   buffer.count.store(n + 1, std::memory_order_release);
+}
+
+void MTProfiler::markFrame()
+{
+   if (!isEnabled()) return;
+   auto& r = registry();
+   auto n = r.frameCount.load(std::memory_order_relaxed);
+   r.frameMarks[n % r.frameMarks.size()] = now();
+   r.frameCount.store(n + 1, std::memory_order_release);
+}
+
+std::vector<MTProfiler::Event> MTProfiler::getEvents()
+{
+   std::vector<Event> events;
+   auto& r = registry();
+   std::lock_guard<std::mutex> lock(r.mutex);
+   for (auto& buffer : r.buffers)
+   {
+      auto capacity = buffer->events.size();
+      // Events are published by the release store of count in Scope::end(),
+      // after the slot at count % capacity has been written. That slot may be
+      // being written right now, and once the buffer has wrapped it's the
+      // oldest one, so it's skipped:
+      auto count = buffer->count.load(std::memory_order_acquire);
+      auto first = count >= capacity ? count - capacity + 1 : 0;
+      auto copyStart = events.size();
+      for (auto i = first; i < count; i++)
+      {
+         events.push_back(buffer->events[i % capacity]);
+      }
+
+      // The owning thread keeps writing while we copy. Drop whatever it may
+      // have overwritten, or started to overwrite, in the meantime:
+      std::atomic_thread_fence(std::memory_order_acquire);
+      auto newCount = buffer->count.load(std::memory_order_relaxed);
+      if (newCount >= capacity && newCount - capacity + 1 > first)
+      {
+         auto overwritten = std::min<uint64_t>(newCount - capacity + 1 - first, count - first);
+         events.erase(events.begin() + copyStart, events.begin() + copyStart + overwritten);
+      }
+   }
+   return events;
+}
+
+bool MTProfiler::exportChromeTrace(const std::filesystem::path& path)
+{
+   auto events = getEvents();
+   std::ofstream os(path);
+   if (!os)
+   {
+      ofLogError("MTProfiler") << "Could not open " << path << " for writing";
+      return false;
+   }
+
+   os << "{\"traceEvents\":[\n";
+   bool isFirst = true;
+   char buffer[64];
+   for (const auto& e : events)
+   {
+      if (!isFirst) os << ",\n";
+      isFirst = false;
+      os << "{\"ph\":\"X\",\"pid\":0,\"tid\":" << e.threadId << ",\"name\":";
+      writeJsonString(os, e.name);
+      // Microseconds, with nanosecond precision:
+      snprintf(buffer, sizeof(buffer), ",\"ts\":%.3f,\"dur\":%.3f", e.start * 1e-3, e.duration * 1e-3);
+      os << buffer;
+      if (e.label[0] != '\0')
+      {
+         os << ",\"args\":{\"label\":";
+         writeJsonString(os, e.label);
+         os << "}";
+      }
+      os << "}";
+   }
+
+   auto& r = registry();
+   auto frameCount = r.frameCount.load(std::memory_order_acquire);
+   auto firstFrame = frameCount > r.frameMarks.size() ? frameCount - r.frameMarks.size() : 0;
+   for (auto i = firstFrame; i < frameCount; i++)
+   {
+      if (!isFirst) os << ",\n";
+      isFirst = false;
+      snprintf(buffer, sizeof(buffer), "%.3f", r.frameMarks[i % r.frameMarks.size()] * 1e-3);
+      os << "{\"ph\":\"i\",\"s\":\"g\",\"pid\":0,\"tid\":0,\"name\":\"Frame\",\"ts\":" << buffer << "}";
+   }
+
+   os << "\n]}\n";
+   return os.good();
+}
+
+void MTProfiler::drawGui()
+{
+   if (!ImGui::Begin("Profiler"))
+   {
+      ImGui::End();
+      return;
+   }
+
+   bool enabled = isEnabled();
+   if (ImGui::Checkbox("Record", &enabled)) setEnabled(enabled);
+   ImGui::SameLine();
+   if (ImGui::Button("Export Trace"))
+   {
+      auto path = ofToDataPath("mt-trace.json", true);
+      if (exportChromeTrace(path)) ofLogNotice("MTProfiler") << "Trace written to " << path;
+   }
+
+   // The last complete frame:
+   auto& r = registry();
+   auto frameCount = r.frameCount.load(std::memory_order_acquire);
+   if (frameCount < 2)
+   {
+      ImGui::Text("No complete frames recorded");
+      ImGui::End();
+      return;
+   }
+   int64_t frameStart = r.frameMarks[(frameCount - 2) % r.frameMarks.size()];
+   int64_t frameEnd = r.frameMarks[(frameCount - 1) % r.frameMarks.size()];
+   ImGui::Text("Frame: %.2f ms", (frameEnd - frameStart) * 1e-6);
+
+   auto events = getEvents();
+   events.erase(std::remove_if(events.begin(),
+                               events.end(),
+                               [&](const Event& e) { return e.start < frameStart || e.start >= frameEnd; }),
+                events.end());
+   std::sort(events.begin(),
+             events.end(),
+             [](const Event& a, const Event& b)
+             {
+                if (a.threadId != b.threadId) return a.threadId < b.threadId;
+                if (a.start != b.start) return a.start < b.start;
+                return a.depth < b.depth;
+             });
+
+   // Self time is the duration minus the durations of the direct children:
+   std::vector<int64_t> selfTimes(events.size());
+   std::vector<size_t> stack;
+   for (size_t i = 0; i < events.size(); i++)
+   {
+      auto& e = events[i];
+      selfTimes[i] = e.duration;
+      while (!stack.empty())
+      {
+         auto& top = events[stack.back()];
+         if (top.threadId == e.threadId && top.depth < e.depth && top.start + top.duration >= e.start) break;
+         stack.pop_back();
+      }
+      if (!stack.empty()) selfTimes[stack.back()] -= e.duration;
+      stack.push_back(i);
+   }
+
+   struct Row
+   {
+      const char* name;
+      const char* label;
+      int calls = 0;
+      int64_t total = 0;
+      int64_t self = 0;
+   };
+   std::unordered_map<std::string, Row> rowsByKey;
+   for (size_t i = 0; i < events.size(); i++)
+   {
+      auto& e = events[i];
+      auto& row = rowsByKey[std::string(e.name) + '\0' + e.label];
+      row.name = e.name;
+      row.label = e.label;
+      row.calls++;
+      row.total += e.duration;
+      row.self += selfTimes[i];
+   }
+
+   std::vector<Row> rows;
+   rows.reserve(rowsByKey.size());
+   for (auto& kv : rowsByKey)
+   {
+      rows.push_back(kv.second);
+   }
+   std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) { return a.self > b.self; });
+
+   if (ImGui::BeginTable("Top Scopes", 5))
+   {
+      ImGui::TableSetupColumn("Scope");
+      ImGui::TableSetupColumn("Label");
+      ImGui::TableSetupColumn("Calls");
+      ImGui::TableSetupColumn("Total ms");
+      ImGui::TableSetupColumn("Self ms");
+      ImGui::TableHeadersRow();
+      for (size_t i = 0; i < std::min<size_t>(rows.size(), 20); i++)
+      {
+         auto& row = rows[i];
+         ImGui::TableNextRow();
+         ImGui::TableNextColumn();
+         ImGui::Text("%s", row.name);
+         ImGui::TableNextColumn();
+         ImGui::Text("%s", row.label);
+         ImGui::TableNextColumn();
+         ImGui::Text("%d", row.calls);
+         ImGui::TableNextColumn();
+         ImGui::Text("%.3f", row.total * 1e-6);
+         ImGui::TableNextColumn();
+         ImGui::Text("%.3f", row.self * 1e-6);
+      }
+      ImGui::EndTable();
+   }
+
+   ImGui::End();
+}
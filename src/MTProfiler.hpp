@@ -0,0 +1,123 @@
+//
+// Created by Cristobal Mendoza.
+//
+
+#ifndef NERVOUSSTRUCTUREOF_MTPROFILER_HPP
+#define NERVOUSSTRUCTUREOF_MTPROFILER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+/// \brief A low overhead, always available profiler for the framework.
+///
+/// Timings are recorded with MT_PROFILE_SCOPE into a ring buffer per thread.
+/// Recording never allocates, except once per thread for its buffer, and when
+/// the profiler is disabled (the default) a scope costs a single relaxed
+/// atomic load. Define MTAF_NO_PROFILER to compile the scopes out entirely.
+///
+/// The framework records MTWindow::update/draw, MTView::update/draw (with the
+/// user's update()/draw() in a nested scope, so that the rest of the outer
+/// scope is framework overhead), operation queue drains, view mode draws,
+/// ImGui and file I/O. The recording can be exported as a Chrome trace, which
+/// chrome://tracing and ui.perfetto.dev can open, or inspected live with
+/// drawGui().
+class MTProfiler
+{
+ public:
+   struct Event
+   {
+      const char* name;
+      // Nanoseconds since the profiler started:
+      int64_t start;
+      int64_t duration;
+      // Nesting depth within its thread:
+      uint32_t depth;
+      uint32_t threadId;
+      // Usually the name of the view, truncated:
+      char label[32];
+   };
+
+   /// \brief The number of events kept per thread. Only takes effect for
+   /// threads that haven't recorded anything yet.
+   static inline size_t BufferCapacity = 1 << 16;
+
+   static void setEnabled(bool enabled)
+   {
+      isRecording.store(enabled, std::memory_order_relaxed);
+   }
+
+   static bool isEnabled()
+   {
+      return isRecording.load(std::memory_order_relaxed);
+   }
+
+   /// \brief Marks the end of a frame of the main loop. MTWindow calls this
+   /// once per main loop iteration.
+   static void markFrame();
+
+   /// \brief Copies the recorded events of every thread, oldest first within
+   /// each thread.
+   static std::vector<Event> getEvents();
+
+   /// \brief Writes the recorded events in the Chrome trace event format.
+   /// \returns false if the file couldn't be written.
+   static bool exportChromeTrace(const std::filesystem::path& path);
+
+   /// \brief Draws an ImGui window with the scopes that took the most time in
+   /// the last complete frame. Call it from a view's drawGui().
+   static void drawGui();
+
+   /// \brief Nanoseconds since the profiler started.
+   static int64_t now();
+
+   /// \brief Records the time between its construction and destruction.
+   class Scope
+   {
+    public:
+      /// \param name Must outlive the profiler, normally a string literal.
+      /// \param label Copied when the scope ends, may be nullptr.
+      explicit Scope(const char* name, const std::string* label = nullptr)
+      {
+         if (isEnabled()) begin(name, label);
+      }
+
+      ~Scope()
+      {
+         if (name) end();
+      }
+
+      Scope(const Scope&) = delete;
+      Scope& operator=(const Scope&) = delete;
+
+    private:
+      const char* name = nullptr;
+      const std::string* label = nullptr;
+      int64_t start = 0;
+
+      void begin(const char* name, const std::string* label);
+      void end();
+   };
+
+ private:
+   static inline std::atomic<bool> isRecording{false};
+};
+
+#ifndef MTAF_NO_PROFILER
+#define MT_PROFILE_CONCAT_INNER(a, b) a##b
+#define MT_PROFILE_CONCAT(a, b) MT_PROFILE_CONCAT_INNER(a, b)
+/// \brief Records the rest of the enclosing scope under `name`.
+#define MT_PROFILE_SCOPE(name) MTProfiler::Scope MT_PROFILE_CONCAT(mtProfileScope, __LINE__)(name)
+/// \brief Records the rest of the enclosing scope under `name`, labelled
+/// with a std::string, such as the name of a view.
+#define MT_PROFILE_SCOPE_LABEL(name, label) \
+   MTProfiler::Scope MT_PROFILE_CONCAT(mtProfileScope, __LINE__)(name, &(label))
+#else
+#define MT_PROFILE_SCOPE(name)
+#define MT_PROFILE_SCOPE_LABEL(name, label)
+#endif
+
+
+#endif  //NERVOUSSTRUCTUREOF_MTPROFILER_HPP
@@ -0,0 +1,546 @@
+//
+// Created by Cristobal Mendoza.
+//
+
+#include "MTStreamingReader.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
+#include "ofLog.h"
+#include "ofParameter.h"
+
+namespace
+{
+const size_t ChunkSize = 64 * 1024;
+
+bool isWhitespace(int c)
+{
+   return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+void appendUTF8(std::string& out, uint32_t codepoint)
+{
+   if (codepoint < 0x80)
+   {
+      out += char(codepoint);
+   }
+   else if (codepoint < 0x800)
+   {
+      out += char(0xC0 | codepoint >> 6);
+      out += char(0x80 | (codepoint & 0x3F));
+   }
+   else if (codepoint < 0x10000)
+   {
+      out += char(0xE0 | codepoint >> 12);
+      out += char(0x80 | (codepoint >> 6 & 0x3F));
+      out += char(0x80 | (codepoint & 0x3F));
+   }
+   else
+   {
+      out += char(0xF0 | codepoint >> 18);
+      out += char(0x80 | (codepoint >> 12 & 0x3F));
+      out += char(0x80 | (codepoint >> 6 & 0x3F));
+      out += char(0x80 | (codepoint & 0x3F));
+   }
+}
+
+void indexParameters(ofParameterGroup& group,
+                     const std::string& prefix,
+                     std::unordered_map<std::string, ofAbstractParameter*>& index)
+{
+   for (auto& parameter : group)
+   {
+      if (!parameter->isSerializable()) continue;
+      auto key = prefix + "/" + parameter->getEscapedName();
+      if (auto childGroup = dynamic_cast<ofParameterGroup*>(parameter.get()))
+      {
+         indexParameters(*childGroup, key, index);
+      }
+      else
+      {
+         index[key] = parameter.get();
+      }
+   }
+}
+}
+
+bool MTStreamingReader::open(const std::filesystem::path& filePath, Format format)
+{
+   file.close();
+   file.clear();
+   file.open(filePath, std::ios::binary);
+   this->format = format;
+   buffer.clear();
+   position = 0;
+   line = 1;
+   lastToken = TokenBeginGroup;
+   hasStarted = false;
+   name.clear();
+   value.clear();
+   path.clear();
+   error.clear();
+   groups.clear();
+   pathLengths.clear();
+   containers.clear();
+   memberCounts.clear();
+   return file.is_open();
+}
+
+MTStreamingReader::Token MTStreamingReader::next()
+{
+   if (lastToken == TokenEnd || lastToken == TokenError) return lastToken;
+
+   // The path of a value or of a closed group only lasts until the next token:
+   if (lastToken == TokenValue || lastToken == TokenEndGroup)
+   {
+      path.resize(pathLengths.back());
+      pathLengths.pop_back();
+   }
+
+   value.clear();
+   if (!file.is_open())
+   {
+      lastToken = fail("the reader is not open");
+   }
+   else
+   {
+      lastToken = format == FormatXML ? nextXML() : nextJSON();
+   }
+   return lastToken;
+}
+
+bool MTStreamingReader::deserialize(ofParameterGroup& group, const CustomValueHandler& handler)
+{
+   // An index of the model, so that every value is matched in constant time:
+   std::unordered_map<std::string, ofAbstractParameter*> index;
+   indexParameters(group, group.getEscapedName(), index);
+
+   while (true)
+   {
+      auto token = next();
+      if (token == TokenEnd) return true;
+      if (token == TokenError)
+      {
+         ofLogError("MTStreamingReader") << error;
+         return false;
+      }
+      if (token != TokenValue) continue;
+
+      auto it = index.find(path);
+      if (it != index.end())
+      {
+         it->second->fromString(value);
+      }
+      else if (handler)
+      {
+         handler(path, value);
+      }
+   }
+}
+
+#pragma mark Input
+
+/// Makes sure that `count` unread bytes are buffered, unless the file ends
+/// first.
+bool MTStreamingReader::ensure(size_t count)
+{
+   while (buffer.size() - position < count)
+   {
+      if (!file) return false;
+      // Drop what was read, so the buffer stays around one chunk:
+      buffer.erase(0, position);
+      position = 0;
+      auto size = buffer.size();
+      buffer.resize(size + ChunkSize);
+      file.read(&buffer[size], ChunkSize);
+      buffer.resize(size + file.gcount());
+   }
+   return true;
+}
+
+int MTStreamingReader::peek(size_t offset)
+{
+   if (!ensure(offset + 1)) return EOF;
+   return static_cast<unsigned char>(buffer[position + offset]);
+}
+
+int MTStreamingReader::get()
+{
+   int c = peek();
+   if (c == EOF) return EOF;
+   position++;
+   if (c == '\n') line++;
+   return c;
+}
+
+bool MTStreamingReader::startsWith(const char* text)
+{
+   auto length = std::strlen(text);
+   return ensure(length) && buffer.compare(position, length, text) == 0;
+}
+
+void MTStreamingReader::skipWhitespace()
+{
+   while (isWhitespace(peek()))
+   {
+      get();
+   }
+}
+
+/// Skips everything up to and including `terminator`.
+bool MTStreamingReader::skipPast(const char* terminator)
+{
+   while (!startsWith(terminator))
+   {
+      if (get() == EOF) return false;
+   }
+   for (auto length = std::strlen(terminator); length > 0; length--)
+   {
+      get();
+   }
+   return true;
+}
+
+MTStreamingReader::Token MTStreamingReader::fail(const std::string& message)
+{
+   error = "Line " + std::to_string(line) + ": " + message;
+   return TokenError;
+}
+
+void MTStreamingReader::pushPath(const std::string& component)
+{
+   pathLengths.push_back(path.size());
+   if (!path.empty()) path += '/';
+   path += component;
+}
+
+#pragma mark XML
+
+MTStreamingReader::Token MTStreamingReader::nextXML()
+{
+   while (true)
+   {
+      // Text between elements is either indentation or mixed content, which
+      // the parameters don't use:
+      while (peek() != '<')
+      {
+         if (get() == EOF)
+         {
+            if (!groups.empty()) return fail("unexpected end of the document");
+            return TokenEnd;
+         }
+      }
+
+      if (startsWith("<?"))
+      {
+         if (!skipPast("?>")) return fail("unterminated processing instruction");
+         continue;
+      }
+      if (startsWith("<!--"))
+      {
+         if (!skipPast("-->")) return fail("unterminated comment");
+         continue;
+      }
+      if (startsWith("<!"))
+      {
+         if (!skipPast(">")) return fail("unterminated declaration");
+         continue;
+      }
+
+      get();
+      if (peek() == '/')
+      {
+         get();
+         readXMLName(name);
+         if (!skipPast(">")) return fail("unterminated end tag");
+         if (groups.empty() || name != groups.back())
+         {
+            return fail("unexpected end tag </" + name + ">");
+         }
+         groups.pop_back();
+         return TokenEndGroup;
+      }
+
+      if (!readXMLName(name)) return fail("expected an element name");
+      bool isEmptyElement;
+      if (!skipXMLAttributes(isEmptyElement)) return fail("unterminated start tag <" + name + ">");
+      value.clear();
+      if (isEmptyElement)
+      {
+         pushPath(name);
+         return TokenValue;
+      }
+
+      // Whether the element is a value or a group is only known once its
+      // first child element, or its end tag, is reached:
+      while (true)
+      {
+         int c = peek();
+         if (c == EOF) return fail("unexpected end of the document");
+         if (c == '&')
+         {
+            readXMLEntity(value);
+         }
+         else if (c != '<')
+         {
+            value += char(get());
+         }
+         else if (startsWith("<![CDATA["))
+         {
+            for (int i = 0; i < 9; i++) get();
+            while (!startsWith("]]>"))
+            {
+               c = get();
+               if (c == EOF) return fail("unterminated CDATA section");
+               value += char(c);
+            }
+            skipPast("]]>");
+         }
+         else if (startsWith("<!--"))
+         {
+            if (!skipPast("-->")) return fail("unterminated comment");
+         }
+         else if (startsWith("<?"))
+         {
+            if (!skipPast("?>")) return fail("unterminated processing instruction");
+         }
+         else if (startsWith("</"))
+         {
+            get();
+            get();
+            std::string endName;
+            readXMLName(endName);
+            if (endName != name) return fail("unexpected end tag </" + endName + ">");
+            if (!skipPast(">")) return fail("unterminated end tag");
+            pushPath(name);
+            return TokenValue;
+         }
+         else
+         {
+            // A child element, which is read by the next call:
+            value.clear();
+            groups.push_back(name);
+            pushPath(name);
+            return TokenBeginGroup;
+         }
+      }
+   }
+}
+
+bool MTStreamingReader::readXMLName(std::string& out)
+{
+   out.clear();
+   while (true)
+   {
+      int c = peek();
+      if (c == EOF || isWhitespace(c) || c == '>' || c == '/' || c == '=') break;
+      out += char(get());
+   }
+   return !out.empty();
+}
+
+bool MTStreamingReader::skipXMLAttributes(bool& isEmptyElement)
+{
+   isEmptyElement = false;
+   while (true)
+   {
+      int c = get();
+      if (c == EOF) return false;
+      if (c == '"' || c == '\'')
+      {
+         // A quoted value can contain '>':
+         int quote = c;
+         do
+         {
+            c = get();
+            if (c == EOF) return false;
+         } while (c != quote);
+      }
+      else if (c == '/' && peek() == '>')
+      {
+         get();
+         isEmptyElement = true;
+         return true;
+      }
+      else if (c == '>')
+      {
+         return true;
+      }
+   }
+}
+
+void MTStreamingReader::readXMLEntity(std::string& out)
+{
+   get();
+   std::string entity;
+   while (entity.size() < 10)
+   {
+      int c = peek();
+      if (c == EOF || c == ';' || c == '<' || c == '&') break;
+      entity += char(get());
+   }
+   if (peek() != ';')
+   {
+      // Not an entity after all:
+      out += '&' + entity;
+      return;
+   }
+   get();
+
+   if (entity == "lt") out += '<';
+   else if (entity == "gt") out += '>';
+   else if (entity == "amp") out += '&';
+   else if (entity == "quot") out += '"';
+   else if (entity == "apos") out += '\'';
+   else if (entity.size() > 1 && entity[0] == '#')
+   {
+      bool isHex = entity[1] == 'x' || entity[1] == 'X';
+      auto codepoint = std::strtoul(entity.c_str() + (isHex ? 2 : 1), nullptr, isHex ? 16 : 10);
+      appendUTF8(out, std::min<unsigned long>(codepoint, 0x10FFFF));
+   }
+   else
+   {
+      out += '&' + entity + ';';
+   }
+}
+
+#pragma mark JSON
+
+MTStreamingReader::Token MTStreamingReader::nextJSON()
+{
+   skipWhitespace();
+   if (!hasStarted)
+   {
+      if (get() != '{') return fail("expected the document to be an object");
+      hasStarted = true;
+      containers.push_back('{');
+      memberCounts.push_back(0);
+      skipWhitespace();
+   }
+   if (containers.empty()) return TokenEnd;
+
+   int c = peek();
+   if (c == '}' || c == ']')
+   {
+      get();
+      if ((c == '}') != (containers.back() == '{')) return fail("mismatched brackets");
+      containers.pop_back();
+      memberCounts.pop_back();
+      // The root object isn't a group:
+      if (containers.empty()) return TokenEnd;
+      name = groups.back();
+      groups.pop_back();
+      return TokenEndGroup;
+   }
+
+   auto& count = memberCounts.back();
+   if (count > 0)
+   {
+      if (get() != ',') return fail("expected ','");
+      skipWhitespace();
+   }
+
+   if (containers.back() == '{')
+   {
+      if (peek() != '"' || !readJSONString(name)) return fail("expected a member name");
+      skipWhitespace();
+      if (get() != ':') return fail("expected ':'");
+      skipWhitespace();
+   }
+   else
+   {
+      name = std::to_string(count);
+   }
+   count++;
+
+   c = peek();
+   if (c == '{' || c == '[')
+   {
+      get();
+      containers.push_back(char(c));
+      memberCounts.push_back(0);
+      groups.push_back(name);
+      pushPath(name);
+      return TokenBeginGroup;
+   }
+
+   if (c == '"')
+   {
+      if (!readJSONString(value)) return fail("unterminated string");
+   }
+   else
+   {
+      if (!readJSONLiteral(value)) return fail("expected a value");
+   }
+   pushPath(name);
+   return TokenValue;
+}
+
+bool MTStreamingReader::readJSONString(std::string& out)
+{
+   out.clear();
+   get();
+   while (true)
+   {
+      int c = get();
+      if (c == EOF) return false;
+      if (c == '"') return true;
+      if (c != '\\')
+      {
+         out += char(c);
+         continue;
+      }
+
+      c = get();
+      switch (c)
+      {
+         case 'b': out += '\b'; break;
+         case 'f': out += '\f'; break;
+         case 'n': out += '\n'; break;
+         case 'r': out += '\r'; break;
+         case 't': out += '\t'; break;
+         case 'u':
+         {
+            auto readHex = [this]()
+            {
+               char digits[5] = {};
+               for (int i = 0; i < 4; i++)
+               {
+                  int d = get();
+                  digits[i] = d == EOF ? '0' : char(d);
+               }
+               return uint32_t(std::strtoul(digits, nullptr, 16));
+            };
+            auto codepoint = readHex();
+            // A surrogate pair:
+            if (codepoint >= 0xD800 && codepoint < 0xDC00 && startsWith("\\u"))
+            {
+               get();
+               get();
+               auto low = readHex();
+               codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+            }
+            appendUTF8(out, codepoint);
+            break;
+         }
+         case EOF: return false;
+         default: out += char(c); break;
+      }
+   }
+}
+
+/// Numbers, true, false and null, as written. null reads as an empty value.
+bool MTStreamingReader::readJSONLiteral(std::string& out)
+{
+   out.clear();
+   while (true)
+   {
+      int c = peek();
+      if (c == EOF || isWhitespace(c) || c == ',' || c == '}' || c == ']') break;
+      out += char(get());
+   }
+   if (out.empty()) return false;
+   if (out == "null") out.clear();
+   return true;
+}
@@ -0,0 +1,141 @@
+//
+// Created by Cristobal Mendoza.
+//
+
+#ifndef NERVOUSSTRUCTUREOF_MTSTREAMINGREADER_HPP
+#define NERVOUSSTRUCTUREOF_MTSTREAMINGREADER_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+class ofParameterGroup;
+
+/// \brief A pull parser for the XML and JSON documents that MTModel writes,
+/// which reads the file in small chunks instead of loading it into a DOM.
+///
+/// The document is seen as a tree of groups and values, like the
+/// ofParameterGroup it was serialized from. Every token has a path built from
+/// the names of its enclosing groups, "Model/Group/Param", the same keys that
+/// MTBinaryWriter uses. In XML, an element is a group when it has child
+/// elements and a value otherwise; attributes are ignored. In JSON, objects
+/// and arrays are groups (array elements are named by their index) and the
+/// root object itself has no name, so its members are the top level.
+class MTStreamingReader
+{
+ public:
+   enum Format
+   {
+      FormatXML = 0,
+      FormatJSON
+   };
+
+   enum Token
+   {
+      TokenBeginGroup = 0,
+      TokenValue,
+      TokenEndGroup,
+      TokenEnd,
+      TokenError
+   };
+
+   /// \brief Receives the path and text of every value that doesn't match a
+   /// parameter.
+   using CustomValueHandler = std::function<void(const std::string& path, const std::string& value)>;
+
+   /// \returns false if the file can't be opened.
+   bool open(const std::filesystem::path& path, Format format);
+
+   bool isOpen() const
+   {
+      return file.is_open();
+   }
+
+   /// \brief Reads the next token. Once the end of the document or an error
+   /// is reached, keeps returning it.
+   Token next();
+
+   /// \brief The name of the current group or value.
+   const std::string& getName() const
+   {
+      return name;
+   }
+
+   /// \brief The text of the current value, with entities and escapes
+   /// decoded. JSON numbers and booleans are returned as they were written.
+   const std::string& getValue() const
+   {
+      return value;
+   }
+
+   /// \brief The path of the current token, including its own name.
+   const std::string& getPath() const
+   {
+      return path;
+   }
+
+   /// \brief The number of groups that enclose the current token.
+   size_t getDepth() const
+   {
+      return groups.size();
+   }
+
+   /// \brief A description of the error that stopped the reader, with the
+   /// line it happened on, or an empty string.
+   const std::string& getError() const
+   {
+      return error;
+   }
+
+   /// \brief Reads the rest of the document, setting every parameter of the
+   /// group, and of its nested groups, as its value is read. Values without
+   /// a parameter are passed to the handler, if there is one.
+   /// \returns false if the document is malformed. The values read up to the
+   /// error have been set.
+   bool deserialize(ofParameterGroup& group, const CustomValueHandler& handler = nullptr);
+
+ private:
+   std::ifstream file;
+   Format format = FormatXML;
+   // The unread part of the file starts at position:
+   std::string buffer;
+   size_t position = 0;
+   size_t line = 1;
+
+   Token lastToken = TokenBeginGroup;
+   bool hasStarted = false;
+   std::string name;
+   std::string value;
+   std::string path;
+   std::string error;
+   // The names of the open groups, and the length of the path before each:
+   std::vector<std::string> groups;
+   std::vector<size_t> pathLengths;
+   // JSON only, the open containers ('{' or '[') and their member counts:
+   std::vector<char> containers;
+   std::vector<size_t> memberCounts;
+
+   bool ensure(size_t count);
+   int peek(size_t offset = 0);
+   int get();
+   bool startsWith(const char* text);
+   void skipWhitespace();
+   bool skipPast(const char* terminator);
+   Token fail(const std::string& message);
+   void pushPath(const std::string& component);
+
+   Token nextXML();
+   bool readXMLName(std::string& out);
+   bool skipXMLAttributes(bool& isEmptyElement);
+   void readXMLEntity(std::string& out);
+
+   Token nextJSON();
+   bool readJSONString(std::string& out);
+   bool readJSONLiteral(std::string& out);
+};
+
+
+#endif  //NERVOUSSTRUCTUREOF_MTSTREAMINGREADER_HPP
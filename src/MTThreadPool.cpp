@@ -0,0 +1,192 @@
+//
+// Created by Cristobal Mendoza.
+//
+
+#include "MTThreadPool.hpp"
+#include "ofLog.h"
+
+namespace
+{
+// The pool that the current thread works for, and its deque in that pool:
+thread_local MTThreadPool* currentPool = nullptr;
+thread_local size_t currentWorkerIndex = 0;
+}
+
+void MTThreadPool::TaskGroup::run(MTOperation&& op)
+{
+   if (!pool) pool = &MTThreadPool::shared();
+   pending.fetch_add(1, std::memory_order_relaxed);
+   pool->push({std::move(op), this});
+}
+
+void MTThreadPool::TaskGroup::wait()
+{
+   if (!pool) return;
+   while (pending.load(std::memory_order_acquire) > 0)
+   {
+      if (pool->tryRunOne()) continue;
+
+      // The remaining tasks are running, or about to be taken, by workers.
+      // Sleep until they are done:
+      std::unique_lock<std::mutex> lock(waitMutex);
+      waitCondition.wait(lock, [this]() { return pending.load(std::memory_order_acquire) == 0; });
+   }
+
+   // The worker that finished the last task may still hold the mutex while it
+   // notifies. Don't let the group be destroyed before it lets go:
+   std::lock_guard<std::mutex> lock(waitMutex);
+}
+
+MTThreadPool::MTThreadPool(size_t numThreads)
+{
+   start(numThreads);
+}
+
+MTThreadPool::~MTThreadPool()
+{
+   stop();
+}
+
+void MTThreadPool::setNumThreads(size_t numThreads)
+{
+   stop();
+   start(numThreads);
+}
+
+void MTThreadPool::start(size_t numThreads)
+{
+   isStopping = false;
+   if (numThreads == 0)
+   {
+      auto hardwareThreads = std::thread::hardware_concurrency();
+      numThreads = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+   }
+
+   for (size_t i = 0; i < numThreads + 1; i++)
+   {
+      workers.push_back(std::make_unique<Worker>());
+   }
+
+   for (size_t i = 0; i < numThreads; i++)
+   {
+      threads.emplace_back(&MTThreadPool::workerLoop, this, i);
+   }
+}
+
+void MTThreadPool::stop()
+{
+   {
+      std::unique_lock<std::mutex> lock(sleepMutex);
+      isStopping = true;
+   }
+   sleepCondition.notify_all();
+   for (auto& t : threads)
+   {
+      t.join();
+   }
+   threads.clear();
+   workers.clear();
+}
+
+MTThreadPool& MTThreadPool::shared()
+{
+   static MTThreadPool pool;
+   return pool;
+}
+
+size_t MTThreadPool::getWorkerIndex() const
+{
+   // Threads that don't belong to the pool share the last deque:
+   return currentPool == this ? currentWorkerIndex : workers.size() - 1;
+}
+
+void MTThreadPool::push(Task&& task)
+{
+   auto& worker = *workers[getWorkerIndex()];
+   {
+      std::unique_lock<std::mutex> lock(worker.mutex);
+      worker.tasks.push_back(std::move(task));
+   }
+   {
+      // Taking the lock keeps a worker from missing the notification between
+      // checking queuedTasks and going to sleep:
+      std::unique_lock<std::mutex> lock(sleepMutex);
+      queuedTasks.fetch_add(1, std::memory_order_release);
+   }
+   sleepCondition.notify_one();
+}
+
+bool MTThreadPool::tryRunOne()
+{
+   auto self = getWorkerIndex();
+   Task task;
+   bool found = false;
+
+   // Our own tasks first, newest first:
+   {
+      auto& worker = *workers[self];
+      std::unique_lock<std::mutex> lock(worker.mutex);
+      if (!worker.tasks.empty())
+      {
+         task = std::move(worker.tasks.back());
+         worker.tasks.pop_back();
+         found = true;
+      }
+   }
+
+   // Then steal the oldest task from someone else:
+   for (size_t i = 1; !found && i < workers.size(); i++)
+   {
+      auto& victim = *workers[(self + i) % workers.size()];
+      std::unique_lock<std::mutex> lock(victim.mutex);
+      if (!victim.tasks.empty())
+      {
+         task = std::move(victim.tasks.front());
+         victim.tasks.pop_front();
+         found = true;
+      }
+   }
+
+   if (!found) return false;
+
+   queuedTasks.fetch_sub(1, std::memory_order_relaxed);
+   try
+   {
+      task.op();
+   }
+   catch (std::exception& e)
+   {
+      ofLogError("MTThreadPool") << "Uncaught exception in task: " << e.what();
+   }
+   catch (...)
+   {
+      // Anything else would terminate the worker, and leave the group's
+      // wait() spinning on a task that never finishes:
+      ofLogError("MTThreadPool") << "Uncaught exception in task";
+   }
+   {
+      // Under the lock, so that a waiting thread can't miss the notification:
+      auto group = task.group;
+      std::lock_guard<std::mutex> lock(group->waitMutex);
+      if (group->pending.fetch_sub(1, std::memory_order_release) == 1)
+      {
+         group->waitCondition.notify_all();
+      }
+   }
+   return true;
+}
+
+void MTThreadPool::workerLoop(size_t index)
+{
+   currentPool = this;
+   currentWorkerIndex = index;
+
+   while (true)
+   {
+      if (tryRunOne()) continue;
+
+      std::unique_lock<std::mutex> lock(sleepMutex);
+      sleepCondition.wait(lock, [this]() { return isStopping || queuedTasks.load(std::memory_order_acquire) > 0; });
+      if (isStopping) return;
+   }
+}
@@ -0,0 +1,114 @@
+//
+// Created by Cristobal Mendoza.
+//
+
+#ifndef NERVOUSSTRUCTUREOF_MTTHREADPOOL_HPP
+#define NERVOUSSTRUCTUREOF_MTTHREADPOOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "MTOperationQueue.hpp"
+
+/// \brief A work-stealing thread pool.
+///
+/// Each worker has its own deque of tasks. Workers run their own tasks newest
+/// first, and steal the oldest tasks of other workers when they run out.
+/// Tasks are submitted through a TaskGroup, which can wait for all of its tasks
+/// to finish. Tasks may submit more tasks to their own group.
+class MTThreadPool
+{
+ public:
+   class TaskGroup
+   {
+    public:
+      /// \brief Creates a group that runs its tasks on the shared pool. The pool
+      /// is not started until the first task is submitted.
+      TaskGroup() = default;
+      explicit TaskGroup(MTThreadPool& pool) : pool(&pool)
+      {
+      }
+
+      ~TaskGroup()
+      {
+         wait();
+      }
+
+      TaskGroup(const TaskGroup&) = delete;
+      TaskGroup& operator=(const TaskGroup&) = delete;
+
+      /// \brief Submits a task. Safe to call from any thread, including from a
+      /// task of this group.
+      void run(MTOperation&& op);
+
+      /// \brief Blocks until every task of the group, including the ones
+      /// submitted by its tasks, has finished. The calling thread runs queued
+      /// tasks while it waits, and sleeps once there is nothing left to run.
+      void wait();
+
+    private:
+      friend class MTThreadPool;
+      MTThreadPool* pool = nullptr;
+      std::atomic<size_t> pending{0};
+      // Signaled when pending drops to 0:
+      std::mutex waitMutex;
+      std::condition_variable waitCondition;
+   };
+
+   /// \param numThreads The number of worker threads. 0 means one less than
+   /// the number of hardware threads, leaving a core for the main thread.
+   explicit MTThreadPool(size_t numThreads = 0);
+   ~MTThreadPool();
+
+   MTThreadPool(const MTThreadPool&) = delete;
+   MTThreadPool& operator=(const MTThreadPool&) = delete;
+
+   /// \brief The pool used by MTView's concurrent updates, created on first use.
+   static MTThreadPool& shared();
+
+   size_t getNumThreads() const
+   {
+      return threads.size();
+   }
+
+   /// \brief Stops the worker threads and starts `numThreads` new ones, with
+   /// the same meaning of 0 as in the constructor. No task may be queued or
+   /// running, so call it between frames, not from a task.
+   void setNumThreads(size_t numThreads);
+
+ private:
+   struct Task
+   {
+      MTOperation op;
+      TaskGroup* group;
+   };
+
+   struct Worker
+   {
+      std::mutex mutex;
+      std::deque<Task> tasks;
+   };
+
+   // One deque per worker thread, plus one for every other thread:
+   std::vector<std::unique_ptr<Worker>> workers;
+   std::vector<std::thread> threads;
+
+   std::mutex sleepMutex;
+   std::condition_variable sleepCondition;
+   std::atomic<size_t> queuedTasks{0};
+   bool isStopping = false;
+
+   void start(size_t numThreads);
+   void stop();
+   void push(Task&& task);
+   bool tryRunOne();
+   void workerLoop(size_t index);
+   size_t getWorkerIndex() const;
+};
+
+
+#endif  //NERVOUSSTRUCTUREOF_MTTHREADPOOL_HPP
@@ -37,6 +37,17 @@ MTView::MTView(std::string _name)
 
 MTView::~MTView()
 {
+   forgetDamage();
+   if (pendingLayoutFlags != 0)
+   {
+      auto it = std::find_if(pendingLayoutViews.begin(), pendingLayoutViews.end(),
+                             [this](const std::pair<int, MTView *> &p) { return p.second == this; });
+      if (it != pendingLayoutViews.end())
+      {
+         pendingLayoutViews.erase(it);
+         std::make_heap(pendingLayoutViews.begin(), pendingLayoutViews.end(), std::greater<>());
+      }
+   }
    subviews.clear();
    ofLogVerbose("MTView") << name << " destroyed";
 }
@@ -83,6 +94,7 @@ void MTView::shiftFrameOrigin(const glm::vec2 &shiftAmount)
 void MTView::setFrameFromCenter(const glm::vec2 &pos, const glm::vec2 &size)
 {
    frame.setFromCenter(pos.x, pos.y, size.x, size.y);
+   invalidateMatrices();
 }
 
 void MTView::setFrameCenter(const glm::vec2 &pos)
@@ -100,7 +112,6 @@ void MTView::setFrameSize(float width, float height)
 {
    frame.setSize(width, height);
    frameChangedInternal();
-   frameChanged();
 }
 
 const glm::vec3 &MTView::getFrameOrigin()
@@ -187,12 +198,18 @@ void MTView::setSize(const glm::vec2 &size)
 
 void MTView::frameChangedInternal()
 {
-   updateMatrices();
-   updateScreenFrame();
+   invalidateMatrices();
+   setNeedsDisplay();
    //    ofLogVerbose() << name << " " << screenFrame;
 
    //	layoutInternal();
 
+   if (deferLayout(PendingFrameChange)) return;
+   notifyFrameChanged();
+}
+
+void MTView::notifyFrameChanged()
+{
    // Call User's frameChanged:
    frameChanged();
 
@@ -210,9 +227,15 @@ void MTView::frameChangedInternal()
 
 void MTView::contentChangedInternal()
 {
-   updateMatrices();
-   updateScreenFrame();  //?
+   invalidateMatrices();
+   setNeedsDisplay();
 
+   if (deferLayout(PendingContentChange)) return;
+   notifyContentChanged();
+}
+
+void MTView::notifyContentChanged()
+{
    contentChanged();
 
    for (const auto &sv : subviews)
@@ -224,7 +247,7 @@ void MTView::contentChangedInternal()
 
 void MTView::superviewFrameChangedInternal()
 {
-   updateMatrices();
+   // Our matrices were already invalidated by the superview.
    performResizePolicy();  // setFrameSize will call frameChangedInternal
    layoutInternal();
    // call the users function:
@@ -233,8 +256,6 @@ void MTView::superviewFrameChangedInternal()
 
 void MTView::superviewContentChangedInternal()
 {
-   updateMatrices();
-   updateScreenFrame();
    for (const auto &sv : subviews)
    {
       sv->superviewContentChangedInternal();
@@ -244,9 +265,75 @@ void MTView::superviewContentChangedInternal()
    superviewContentChanged();
 }
 
+int MTView::layoutTransactionDepth = 0;
+std::vector<std::pair<int, MTView *>> MTView::pendingLayoutViews;
+
+void MTView::beginLayout()
+{
+   layoutTransactionDepth++;
+}
+
+void MTView::commitLayout()
+{
+   if (layoutTransactionDepth == 0)
+   {
+      ofLogError("MTView") << "commitLayout() called without a matching beginLayout()";
+      return;
+   }
+
+   if (layoutTransactionDepth > 1)
+   {
+      layoutTransactionDepth--;
+      return;
+   }
+
+   // The transaction stays open while we process, so that the changes made by
+   // resize policies are queued too. They are always deeper than the view being
+   // processed, so the heap hands them out after their superviews:
+   while (!pendingLayoutViews.empty())
+   {
+      std::pop_heap(pendingLayoutViews.begin(), pendingLayoutViews.end(), std::greater<>());
+      auto view = pendingLayoutViews.back().second;
+      pendingLayoutViews.pop_back();
+
+      // The view stays marked as pending meanwhile, so that a frame change
+      // made by its resize policy is notified below, together with the rest:
+      if (view->pendingLayoutFlags & PendingSuperviewChange)
+      {
+         view->performResizePolicy();
+         view->layoutInternal();
+      }
+
+      auto flags = view->pendingLayoutFlags;
+      view->pendingLayoutFlags = 0;
+      if (flags & PendingContentChange) view->notifyContentChanged();
+      if (flags & PendingFrameChange) view->notifyFrameChanged();
+   }
+
+   layoutTransactionDepth = 0;
+}
+
+bool MTView::deferLayout(int flags)
+{
+   if (layoutTransactionDepth == 0) return false;
+
+   if (pendingLayoutFlags == 0)
+   {
+      int depth = 0;
+      for (auto sv = superview; sv != nullptr; sv = sv->superview)
+      {
+         depth++;
+      }
+      pendingLayoutViews.emplace_back(depth, this);
+      std::push_heap(pendingLayoutViews.begin(), pendingLayoutViews.end(), std::greater<>());
+   }
+   pendingLayoutFlags |= flags;
+   return true;
+}
+
 void MTView::layoutInternal()
 {
-   onLayout();
+   invokeCallback(&Callbacks::onLayout);
    layout();
 }
 
@@ -264,26 +351,11 @@ void MTView::performResizePolicy()
    }
 }
 
-void MTView::updateScreenFrame()
-{
-   if (superview)
-   {
-      glm::vec4 screenFramePosition = superview->contentMatrix * glm::vec4(frame.getPosition(), 1);
-      screenFrame.setPosition(screenFramePosition);
-      auto size = glm::vec4(getFrameSize(), 0, 0) * superview->contentMatrix;  //TODO: check if this is correct
-      screenFrame.setSize(size.x, size.y);
-   }
-   else
-   {
-      screenFrame = frame;
-   }
-}
-
 //TODO: Check to see if transformPoint works
 glm::vec2 MTView::transformPoint(glm::vec2 &coords, const MTView *toView)
 {
-   auto windowCoords = frameMatrix * glm::vec4(coords.x, coords.y, 1, 1);
-   return toView->invFrameMatrix * windowCoords;
+   auto windowCoords = getFrameMatrix() * glm::vec4(coords.x, coords.y, 1, 1);
+   return toView->getInvFrameMatrix() * windowCoords;
 }
 
 //glm::vec2 MTView::transformPoint(glm::vec2 &coords,
@@ -294,8 +366,8 @@ glm::vec2 MTView::transformPoint(glm::vec2 &coords, const MTView *toView)
 
 glm::vec2 MTView::transformFramePointToContent(glm::vec2 &coords)
 {
-   auto windowCoords = frameMatrix * glm::vec4(coords.x, coords.y, 1, 1);
-   auto result = invContentMatrix * windowCoords;
+   auto windowCoords = getFrameMatrix() * glm::vec4(coords.x, coords.y, 1, 1);
+   auto result = getInvContentMatrix() * windowCoords;
    return glm::vec2(result.x, result.y);
 }
 
@@ -303,7 +375,7 @@ glm::vec2 MTView::transformFramePointToContent(glm::vec2 &coords)
 /// coordinates to content coordinates.
 glm::vec2 MTView::transformFramePointToScreen(glm::vec2 &coords)
 {
-   auto windowCoords = frameMatrix * glm::vec4(coords.x, coords.y, 1, 1);
+   auto windowCoords = getFrameMatrix() * glm::vec4(coords.x, coords.y, 1, 1);
    return glm::vec2(windowCoords);
 }
 
@@ -322,8 +394,11 @@ void MTView::setSuperview(MTView *view)
    superview = view;
    setWindow(view->window);
    frameChangedInternal();
-   performResizePolicy();
-   layoutInternal();
+   if (!deferLayout(PendingSuperviewChange))
+   {
+      performResizePolicy();
+      layoutInternal();
+   }
    ofEventArgs voidArgs;
    addedToSuperviewEvent.notify(voidArgs);
 }
@@ -354,6 +429,8 @@ void MTView::addSubview(std::shared_ptr<MTView> subview)
           //});
    }
    subviews.push_back(subview);
+   updateSpatialIndex();
+   invalidateWindowLists();
 }
 
 const std::vector<std::shared_ptr<MTView>> &MTView::getSubviews() const
@@ -409,6 +486,7 @@ std::shared_ptr<MTView> MTView::removeLastSubview()
 
 void MTView::resetWindowPointer()
 {
+   forgetDamage();
    window.reset();
    ofEventArgs args;
    removedFromWindowEvent.notify(args);
@@ -424,10 +502,14 @@ std::shared_ptr<MTView> MTView::removeSubview(MTView *view)
    auto iter = std::find_if(subviews.begin(), subviews.end(), [&](std::shared_ptr<MTView> &p) { return p.get() == view; });
    if (iter <= subviews.end())
    {
+      invalidateWindowLists();
+      invalidateSubtreeBounds();
+      setNeedsDisplay();
       view->superview = nullptr;
       view->resetWindowPointer();
       auto res = *iter;
       subviews.erase(iter);
+      updateSpatialIndex();
       return res;
    }
 
@@ -436,6 +518,9 @@ std::shared_ptr<MTView> MTView::removeSubview(MTView *view)
 
 void MTView::removeAllSubviews(bool recursive)
 {
+   invalidateWindowLists();
+   invalidateSubtreeBounds();
+   setNeedsDisplay();
    for (auto &view : subviews)
    {
       if (recursive) view->removeAllSubviews();
@@ -443,6 +528,37 @@ void MTView::removeAllSubviews(bool recursive)
       view->resetWindowPointer();
    }
    subviews.clear();
+   updateSpatialIndex();
+}
+
+void MTView::setSpatialIndexPolicy(MTViewSpatialIndexPolicy policy)
+{
+   spatialIndexPolicy = policy;
+   updateSpatialIndex();
+}
+
+void MTView::updateSpatialIndex()
+{
+   bool useIndex = spatialIndexPolicy == SpatialIndexAlways ||
+                   (spatialIndexPolicy == SpatialIndexAuto && subviews.size() > MTViewSpatialIndex::AutoThreshold);
+   if (useIndex)
+   {
+      if (!spatialIndex) spatialIndex = std::make_unique<MTViewSpatialIndex>();
+      spatialIndex->invalidate();
+   }
+   else
+   {
+      spatialIndex.reset();
+   }
+}
+
+void MTView::invalidateWindowLists()
+{
+   if (auto w = window.lock())
+   {
+      w->invalidateRenderList();
+      w->guiListDirty = true;
+   }
 }
 
 std::weak_ptr<MTWindow> MTView::getWindow()
@@ -486,7 +602,7 @@ void MTView::setup(ofEventArgs &args)
    if (!isSetUp)
    {
       setup();
-      onSetup(this);
+      invokeCallback(&Callbacks::onSetup, this);
       isSetUp = true;
       for (const auto &sv : subviews)
       {
@@ -497,18 +613,36 @@ void MTView::setup(ofEventArgs &args)
 
 void MTView::update(ofEventArgs &args)
 {
-   while (!updateOpQueue.empty())
+   if (concurrentUpdate)
+   {
+      if (auto w = window.lock())
+      {
+         drainUpdateOperations();
+         auto &tasks = w->updateTasks;
+         tasks.run([this, &tasks]() { updateConcurrently(tasks); });
+         return;
+      }
+   }
+
+   MT_PROFILE_SCOPE_LABEL("MTView::update", name.get());
+   if (!updateOpQueue.empty())
    {
-      auto op = updateOpQueue.front();
-      op();
-      updateOpQueue.pop();
+      MT_PROFILE_SCOPE("MTView update ops");
+      updateOpQueue.drain();
    }
 
-   //Call user's update()
-   update();
-   onUpdate(this);
+   // Draw operations are only run when the view draws, and layers and
+   // on-demand windows only draw when they are invalidated:
+   if (!drawOpQueue.empty()) setNeedsDisplay();
 
-   if (MTApp::Instance()->autoUpdateAppModes) currentViewMode->update();
+   {
+      MT_PROFILE_SCOPE("MTView user update");
+      //Call user's update()
+      update();
+      invokeCallback(&Callbacks::onUpdate, this);
+
+      if (MTApp::Instance()->autoUpdateAppModes) currentViewMode->update();
+   }
 
    for (const auto &sv : subviews)
    {
@@ -516,30 +650,184 @@ void MTView::update(ofEventArgs &args)
    }
 }
 
+void MTView::drainUpdateOperations()
+{
+   updateOpQueue.drain();
+   if (!drawOpQueue.empty()) setNeedsDisplay();
+
+   for (const auto &sv : subviews)
+   {
+      sv->drainUpdateOperations();
+   }
+}
+
+void MTView::updateConcurrently(MTThreadPool::TaskGroup &tasks)
+{
+   {
+      MT_PROFILE_SCOPE_LABEL("MTView user update", name.get());
+      update();
+      invokeCallback(&Callbacks::onUpdate, this);
+
+      if (currentViewMode && MTApp::Instance()->autoUpdateAppModes) currentViewMode->update();
+   }
+
+   // The hierarchy can't change until the window's barrier, so the raw
+   // pointers stay valid:
+   for (const auto &sv : subviews)
+   {
+      auto view = sv.get();
+      tasks.run([view, &tasks]() { view->updateConcurrently(tasks); });
+   }
+}
+
 void MTView::draw(ofEventArgs &args)
 {
    //	ofPushView();
    //	ofViewport(screenFrame);
    if (!isRenderingEnabled) return;
 
+   MT_PROFILE_SCOPE_LABEL("MTView::draw", name.get());
+
+   // Normally a no-op, the window resolves all matrices before drawing. But
+   // a draw operation or a superview's draw() may have moved us:
+   resolveMatrices();
+
    auto w = window.lock();
-   //					glScissor((int)pcmd->ClipRect.x, (int)(fb_height - pcmd->ClipRect.w), (int)(pcmd->ClipRect.z - pcmd->ClipRect.x), (int)(pcmd->ClipRect.w - pcmd->ClipRect.y));
-   if (clipToFrame)
+   if (w && w->isCulling)
+   {
+      if (!getSubtreeScreenBounds().intersects(w->cullRect))
+      {
+         w->frameCulledViews += subtreeSize;
+         return;
+      }
+   }
+   if (w)
    {
-      glEnable(GL_SCISSOR_TEST);
-      glScissor(screenFrame.x,
-                w->getWindowSize().y - (screenFrame.y + screenFrame.height),
-                screenFrame.width,
-                screenFrame.height);
+      w->frameDrawnViews++;
+      if (w->isPartialRedraw) drawnBounds = getSubtreeScreenBounds();
    }
+
+   if (layerBacked && !isRenderingLayer)
+   {
+      drawLayer(args);
+      return;
+   }
+   else if (!layerBacked && layer)
+   {
+      // Release the FBO here, where we know that the right GL context is current:
+      layer.reset();
+   }
+
+   // Nothing inside of us is visible if our frame is clipped away entirely:
+   bool isClipping = clipToFrame && w;
+   if (isClipping && !w->pushClipRect(screenFrame))
+   {
+      w->popClipRect();
+      return;
+   }
+
    ofPushMatrix();
+   drawContents(frameMatrix, contentMatrix, MTApp::Instance()->autoDrawViewModes);
+   ofPopMatrix();
+
+   // Draw subviews:
+   for (const auto &sv : subviews)
+   {
+      sv->draw(args);
+   }
+
+   if (isClipping)
+   {
+      w->popClipRect();
+   }
+}
+
+void MTView::setLayerBacked(bool layerBacked)
+{
+   this->layerBacked = layerBacked;
+   setNeedsDisplay();
+}
+
+void MTView::setNeedsDisplay()
+{
+   for (auto v = this; v != nullptr; v = v->superview)
+   {
+      if (v->layerBacked) v->layerNeedsDisplay = true;
+   }
+
+   if (auto w = window.lock()) w->addDamagedView(this);
+}
+
+void MTView::forgetDamage()
+{
+   if (!isDamagePending) return;
+   isDamagePending = false;
+   if (auto w = window.lock()) w->removeDamagedView(this);
+}
+
+void MTView::drawLayer(ofEventArgs &args)
+{
+   auto w = window.lock();
+   if (!w || frame.width <= 0 || frame.height <= 0) return;
+
+   // Window coordinates are framebuffer pixels, so the size of the screen
+   // frame includes the content scale of the superviews and the pixel density
+   // of the display. Sizing the layer by it keeps it sharp:
+   glm::vec2 scale(screenFrame.width / frame.width, screenFrame.height / frame.height);
+   int width = std::ceil(frame.width * scale.x);
+   int height = std::ceil(frame.height * scale.y);
+   if (width <= 0 || height <= 0) return;
+
+   if (!layer || layer->getWidth() != width || layer->getHeight() != height)
+   {
+      layer = std::make_unique<ofFbo>();
+      layer->allocate(width, height, GL_RGBA);
+      layerNeedsDisplay = true;
+   }
+
+   if (layerNeedsDisplay)
+   {
+      // Draw the subtree in frame coordinates, scaled to the layer's pixels.
+      // The whole layer gets drawn, even the parts that are offscreen:
+      auto windowToLayer = glm::scale(glm::vec3(scale.x, scale.y, 1)) * getInvFrameMatrix();
+      w->pushRenderTarget(windowToLayer, height, screenFrame, false);
+      layer->begin();
+      ofClear(0, 0, 0, 0);
+      // Accumulate premultiplied colors, and the coverage in alpha, so that
+      // translucent content isn't darkened twice when composited:
+      ofPushStyle();
+      ofEnableAlphaBlending();
+      glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+      ofMultMatrix(windowToLayer);
+      isRenderingLayer = true;
+      draw(args);
+      isRenderingLayer = false;
+      ofPopStyle();
+      layer->end();
+      w->popRenderTarget();
+      layerNeedsDisplay = false;
+   }
+
+   ofPushMatrix();
+   ofPushStyle();
+   ofMultMatrix(frameMatrix);
+   ofSetColor(255);
+   ofEnableAlphaBlending();
+   glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+   layer->draw(0, 0, frame.width, frame.height);
+   ofPopStyle();
+   ofPopMatrix();
+}
+
+void MTView::drawContents(const glm::mat4 &viewFrameMatrix, const glm::mat4 &viewContentMatrix, bool drawViewMode)
+{
    ofSetMatrixMode(ofMatrixMode::OF_MATRIX_MODELVIEW);
    // Draw the background
    if (isDrawingBackground)
    {
       ofPushMatrix();
       // The background is drawn in Frame coordinates:
-      ofMultMatrix(frameMatrix);
+      ofMultMatrix(viewFrameMatrix);
       ofFill();
       ofSetColor(backgroundColor.get());
       ofSetRectMode(OF_RECTMODE_CORNER);
@@ -549,47 +837,52 @@ void MTView::draw(ofEventArgs &args)
 
    // Load the content coordinates:
    //    ofLoadIdentityMatrix();
-   ofMultMatrix(contentMatrix);
+   ofMultMatrix(viewContentMatrix);
 
    // Execute operations in the draw queue:
-   while (!drawOpQueue.empty())
+   if (!drawOpQueue.empty())
    {
-      auto op = drawOpQueue.front();
-      op();
-      drawOpQueue.pop();
+      MT_PROFILE_SCOPE("MTView draw ops");
+      drawOpQueue.drain();
    }
 
-   // Call the user's draw() function(s)
-   draw();
-   onDraw(this);
+   {
+      MT_PROFILE_SCOPE("MTView user draw");
+      // Call the user's draw() function(s)
+      draw();
+      invokeCallback(&Callbacks::onDraw, this);
+   }
 
    // Should I fire a drawEvent here instead? It would make sense...
-   if (MTApp::Instance()->autoDrawViewModes)
+   if (drawViewMode)
    {
       if (currentViewMode != nullptr)
       {
+         MT_PROFILE_SCOPE("MTViewMode::draw");
          currentViewMode->draw();
       }
    }
+}
 
-   ofPopMatrix();
+bool MTView::drawGuiInternal()
+{
+   drawGui();
+   invokeCallback(&Callbacks::onDrawGui);
+   return !hasDefaultDrawGui || (callbackTable && callbackTable->onDrawGui);
+}
 
-   // Draw subviews:
-   for (const auto &sv : subviews)
-   {
-      sv->draw(args);
-   }
+MTView::Callbacks &MTView::callbacks()
+{
+   if (!callbackTable) callbackTable = std::make_unique<Callbacks>();
 
-   if (clipToFrame)
+   // onDrawGui may be about to be set, so the window has to look at this
+   // view again:
+   if (isGuiProbed && !hasGui)
    {
-      glDisable(GL_SCISSOR_TEST);
+      isGuiProbed = false;
+      invalidateWindowLists();
    }
-}
-
-void MTView::drawGuiInternal()
-{
-   drawGui();
-   onDrawGui();
+   return *callbackTable;
 }
 
 void MTView::exit(ofEventArgs &args)
@@ -599,7 +892,7 @@ void MTView::exit(ofEventArgs &args)
       currentViewMode->exit();
    }
    exit();
-   onExit(this);
+   invokeCallback(&Callbacks::onExit, this);
    //for (const auto &sv : subviews)
    //{
    //   sv->exit(args);
@@ -611,7 +904,7 @@ void MTView::windowResized(ofResizeEventArgs &resize)
    //	updateMatrices();
    //	layoutInternal();
    windowResized(resize.width, resize.height);
-   onWindowResized(this, resize.width, resize.height);
+   invokeCallback(&Callbacks::onWindowResized, this, resize.width, resize.height);
    for (const auto &sv : subviews)
    {
       sv->windowResized(resize);
@@ -624,7 +917,7 @@ void MTView::keyPressedInternal(ofKeyEventArgs &key)
    ofLogVerbose("MTView") << "keyPressed: " << name.get() + " " << (char) key.key;
    keyPressed(key.key);
    keyPressed(key);
-   onKeyPressed(this, key.key);
+   invokeCallback(&Callbacks::onKeyPressed, this, key.key);
    keyPressedEvent.notify(this, key);
 }
 
@@ -633,7 +926,7 @@ void MTView::keyReleasedInternal(ofKeyEventArgs &key)
    ofLogVerbose("MTView") << "keyReleasedInternal: " << name.get() + " " << (char) key.key;
    keyReleased(key.key);
    keyReleased(key);
-   onKeyReleased(this, key.key);
+   invokeCallback(&Callbacks::onKeyReleased, this, key.key);
    keyReleasedEvent.notify(this, key);
 }
 
@@ -642,11 +935,24 @@ void MTView::keyReleasedInternal(ofKeyEventArgs &key)
 void MTView::updateMousePositionsWithWindowCoordinate(glm::vec2 windowCoord)
 {
    prevContentMouse = contentMouse;
-   contentMouse = glm::vec2(invContentMatrix * glm::vec4(windowCoord.x, windowCoord.y, 1, 1));
+   contentMouse = glm::vec2(getInvContentMatrix() * glm::vec4(windowCoord.x, windowCoord.y, 1, 1));
    prevWindowMouse = windowMouse;
    windowMouse = windowCoord;
 }
 
+void MTView::getContentMouseSamples(std::vector<MTMouseSample> &samples)
+{
+   samples.clear();
+   auto w = window.lock();
+   if (!w) return;
+
+   auto &invContent = getInvContentMatrix();
+   for (const auto &s : w->getMouseSamples())
+   {
+      samples.push_back({glm::vec2(invContent * glm::vec4(s.position.x, s.position.y, 1, 1)), s.time});
+   }
+}
+
 void MTView::updateMouseDownPositionsWithWindowCoordinate(glm::vec2 windowCoord)
 {
    updateMousePositionsWithWindowCoordinate(windowCoord);
@@ -666,7 +972,7 @@ void MTView::mouseMoved(ofMouseEventArgs &mouse)
    updateMousePositionsWithWindowCoordinate(mouse);
    ofMouseEventArgs localArgs = ofMouseEventArgs(ofMouseEventArgs::Moved, contentMouse.x, contentMouse.y, mouse.button);
    mouseMoved(contentMouse.x, contentMouse.y);
-   onMouseMoved(this, contentMouse.x, contentMouse.y);
+   invokeCallback(&Callbacks::onMouseMoved, this, contentMouse.x, contentMouse.y);
    mouseMovedEvent.notify(this, localArgs);
 }
 
@@ -682,7 +988,7 @@ void MTView::mouseDragged(ofMouseEventArgs &mouse)
 
    ofMouseEventArgs localArgs = ofMouseEventArgs(ofMouseEventArgs::Dragged, contentMouse.x, contentMouse.y, mouse.button);
    mouseDragged(contentMouse.x, contentMouse.y, mouse.button);
-   onMouseDragged(this, contentMouse.x, contentMouse.y, mouse.button);
+   invokeCallback(&Callbacks::onMouseDragged, this, contentMouse.x, contentMouse.y, mouse.button);
    mouseDraggedEvent.notify(this, localArgs);
 }
 
@@ -693,7 +999,7 @@ void MTView::mousePressed(ofMouseEventArgs &mouse)
 
    ofMouseEventArgs localArgs = ofMouseEventArgs(ofMouseEventArgs::Pressed, contentMouse.x, contentMouse.y, mouse.button);
    mousePressed(contentMouse.x, contentMouse.y, mouse.button);
-   onMousePressed(this, contentMouse.x, contentMouse.y, mouse.button);
+   invokeCallback(&Callbacks::onMousePressed, this, contentMouse.x, contentMouse.y, mouse.button);
    mousePressedEvent.notify(this, localArgs);
 }
 
@@ -711,7 +1017,7 @@ void MTView::mouseReleased(ofMouseEventArgs &mouse)
 
    isMouseDown = false;
    mouseReleased(contentMouse.x, contentMouse.y, mouse.button);
-   onMouseReleased(this, contentMouse.x, contentMouse.y, mouse.button);
+   invokeCallback(&Callbacks::onMouseReleased, this, contentMouse.x, contentMouse.y, mouse.button);
    mouseReleasedEvent.notify(this, localArgs);
 }
 
@@ -722,7 +1028,7 @@ void MTView::mouseScrolled(ofMouseEventArgs &mouse)
    mouseWheel = mouse.scrollY;
    //    ofLogNotice("MTView::mouseScrolled") << "scrollX and scrollY are in Window coordinates"
    mouseScrolled(contentMouse.x, contentMouse.y, mouse.scrollX, mouse.scrollY);
-   onMouseScrolled(this, contentMouse.x, contentMouse.y, mouse.scrollX, mouse.scrollY);
+   invokeCallback(&Callbacks::onMouseScrolled, this, contentMouse.x, contentMouse.y, mouse.scrollX, mouse.scrollY);
    mouseScrolledEvent.notify(this, localArgs);
 }
 
@@ -731,7 +1037,7 @@ void MTView::mouseEntered(ofMouseEventArgs &mouse)
    ofLogVerbose("MTView") << "mouseEntered: " << name.get();
    ofMouseEventArgs localArgs = ofMouseEventArgs(ofMouseEventArgs::Entered, contentMouse.x, contentMouse.y, mouse.button);
    mouseEntered(contentMouse.x, contentMouse.y);
-   onMouseEntered(this, contentMouse.x, contentMouse.y);
+   invokeCallback(&Callbacks::onMouseEntered, this, contentMouse.x, contentMouse.y);
    mouseEnteredEvent.notify(this, localArgs);
 }
 
@@ -740,7 +1046,7 @@ void MTView::mouseExited(ofMouseEventArgs &mouse)
    ofLogVerbose("MTView") << "mouseExited: " << name.get();
    ofMouseEventArgs localArgs = ofMouseEventArgs(ofMouseEventArgs::Exited, contentMouse.x, contentMouse.y, mouse.button);
    mouseExited(contentMouse.x, contentMouse.y);
-   onMouseExited(this, contentMouse.x, contentMouse.y);
+   invokeCallback(&Callbacks::onMouseExited, this, contentMouse.x, contentMouse.y);
    mouseExitedEvent.notify(this, localArgs);
 }
 
@@ -760,7 +1066,7 @@ void MTView::modelLoaded(ofEventArgs &args)
        [this]()
        {
           modelLoaded();
-          onModelLoaded(this);
+          invokeCallback(&Callbacks::onModelLoaded, this);
        });
 
    // Recurse:
@@ -772,12 +1078,19 @@ void MTView::modelLoaded(ofEventArgs &args)
 
 MTView *MTView::hitTest(glm::vec2 &windowCoord)
 {
-   if (subviews.size() > 0)
+   if (spatialIndex)
+   {
+      if (auto sv = spatialIndex->query(windowCoord, subviews))
+      {
+         return sv->hitTest(windowCoord);
+      }
+   }
+   else if (subviews.size() > 0)
    {
       for (int i = subviews.size() - 1; i >= 0; i--)
       {
          auto &sv = subviews[i];
-         if (sv->screenFrame.inside(windowCoord))
+         if (sv->getScreenFrame().inside(windowCoord))
          {
             return sv->hitTest(windowCoord);
          }
@@ -803,8 +1116,81 @@ bool MTView::hasFocus()
 
 void MTView::updateMatrices()
 {
+   invalidateMatrices();
+   resolveMatrices();
+}
+
+void MTView::invalidateMatrices()
+{
+   // If we are already dirty, so is everything below us:
+   if (!matricesDirty)
+   {
+      markMatricesDirty();
+   }
+
+   // Our screen frame is about to change, so our entry in the superview's
+   // index is stale:
+   if (superview && superview->spatialIndex)
+   {
+      superview->spatialIndex->invalidate(this);
+   }
+
+   // Flag the path up to the root so that the resolve pass can find us:
+   for (auto sv = superview; sv != nullptr && !sv->subviewMatricesDirty; sv = sv->superview)
+   {
+      sv->subviewMatricesDirty = true;
+   }
+
+   invalidateSubtreeBounds();
+}
+
+void MTView::invalidateSubtreeBounds()
+{
+   subtreeBoundsDirty = true;
+   for (auto sv = superview; sv != nullptr && !sv->subtreeBoundsDirty; sv = sv->superview)
+   {
+      sv->subtreeBoundsDirty = true;
+   }
+}
+
+const ofRectangle &MTView::getSubtreeScreenBounds()
+{
+   if (subtreeBoundsDirty)
+   {
+      subtreeBounds = getScreenFrame();
+      subtreeSize = 1;
+      for (const auto &sv : subviews)
+      {
+         subtreeBounds.growToInclude(sv->getSubtreeScreenBounds());
+         subtreeSize += sv->subtreeSize;
+      }
+      subtreeBoundsDirty = false;
+   }
+
+   return subtreeBounds;
+}
+
+void MTView::markMatricesDirty()
+{
+   matricesDirty = true;
+   subtreeBoundsDirty = true;
+   subviewMatricesDirty = !subviews.empty();
+   for (const auto &sv : subviews)
+   {
+      if (!sv->matricesDirty) sv->markMatricesDirty();
+   }
+
+   // All of our subviews move with us:
+   if (spatialIndex) spatialIndex->invalidate();
+}
+
+void MTView::resolveMatrices() const
+{
+   if (!matricesDirty) return;
+
    if (superview)
    {
+      superview->resolveMatrices();
       frameMatrix = glm::translate(superview->contentMatrix, frame.getPosition());
    }
    else
@@ -812,16 +1198,38 @@ void MTView::updateMatrices()
       frameMatrix = glm::translate(glm::mat4(1.0f), frame.getPosition());
    }
 
-   invFrameMatrix = glm::inverse(frameMatrix);
    auto scaleMatrix = glm::scale(glm::vec3(contentScaleX.get(), contentScaleY.get(), 1));
    auto transMatrix = glm::translate(frameMatrix, content.getPosition());
    contentMatrix = transMatrix * scaleMatrix;
-   invContentMatrix = glm::inverse(contentMatrix);
+
+   // Update the screen frame:
+   if (superview)
+   {
+      glm::vec4 screenFramePosition = superview->contentMatrix * glm::vec4(frame.getPosition(), 1);
+      screenFrame.setPosition(screenFramePosition);
+      auto size = glm::vec4(frame.width, frame.height, 0, 0) * superview->contentMatrix;  //TODO: check if this is correct
+      screenFrame.setSize(size.x, size.y);
+   }
+   else
+   {
+      screenFrame = frame;
+   }
+
+   invFrameMatrixDirty = true;
+   invContentMatrixDirty = true;
+   matricesDirty = false;
+}
+
+void MTView::resolveSubviewMatrices()
+{
+   resolveMatrices();
+   if (!subviewMatricesDirty) return;
 
    for (const auto &sv : subviews)
    {
-      sv->updateMatrices();
+      sv->resolveSubviewMatrices();
    }
+   subviewMatricesDirty = false;
 }
 
 const ofParameter<ofFloatColor> &MTView::getBackgroundColor() const
@@ -831,21 +1239,35 @@ const ofParameter<ofFloatColor> &MTView::getBackgroundColor() const
 
 const glm::mat4 &MTView::getContentMatrix() const
 {
+   resolveMatrices();
    return contentMatrix;
 }
 
 const glm::mat4 &MTView::getInvContentMatrix() const
 {
+   resolveMatrices();
+   if (invContentMatrixDirty)
+   {
+      invContentMatrix = glm::inverse(contentMatrix);
+      invContentMatrixDirty = false;
+   }
    return invContentMatrix;
 }
 
 const glm::mat4 &MTView::getInvFrameMatrix() const
 {
+   resolveMatrices();
+   if (invFrameMatrixDirty)
+   {
+      invFrameMatrix = glm::inverse(frameMatrix);
+      invFrameMatrixDirty = false;
+   }
    return invFrameMatrix;
 }
 
 const glm::mat4 &MTView::getFrameMatrix() const
 {
+   resolveMatrices();
    return frameMatrix;
 }
 
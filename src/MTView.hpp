@@ -12,6 +12,11 @@
 
 #include "ofxMTAppFramework.h"
 #include "ofxImGui.h"
+#include "ofFbo.h"
+#include "MTViewSpatialIndex.hpp"
+#include "MTOperationQueue.hpp"
+#include "MTThreadPool.hpp"
+#include "MTProfiler.hpp"
 
 enum MTViewResizePolicy
 {
@@ -31,6 +36,19 @@ enum MTViewResizePolicy
    ResizePolicyAspectRatio
 };
 
+enum MTViewSpatialIndexPolicy
+{
+   // Default. Index the subviews for hit testing once there are more than
+   // MTViewSpatialIndex::AutoThreshold of them.
+   SpatialIndexAuto = 0,
+
+   // Always index the subviews.
+   SpatialIndexAlways,
+
+   // Never index the subviews, hit testing scans them in reverse order.
+   SpatialIndexNever
+};
+
 
 class MTModel;
 
@@ -281,27 +299,63 @@ class MTView : public MTEventListenerStore
    // override, so if you override an event method and
    // provide a lambda, the override will be called first.
    //
+   // The lambdas live in a separate table that is only allocated once one
+   // of them is set, so views that don't use them only pay for a pointer.
+   // Unset lambdas are skipped. Usage:
+   //
+   //    view->callbacks().onDraw = [](MTView* view) { ... };
+   //
    //--------------------------------------------------//
 
-   std::function<void(MTView*)> onModelLoaded = [](MTView* view) {};
-   std::function<void(MTView*)> onSetup = [](MTView* view) {};
-   std::function<void(MTView*)> onUpdate = [](MTView* view) {};
-   std::function<void(MTView*)> onDraw = [](MTView* view) {};
-   std::function<void(MTView*)> onExit = [](MTView* view) {};
-   std::function<void(MTView*, int, int)> onWindowResized = [](MTView* view, int w, int h) {};
-   std::function<void(MTView*)> onSuperviewFrameChanged = [](MTView* view) {};
-   std::function<void(MTView*)> onFrameChanged = [](MTView* view) {};
-   std::function<void(MTView*)> onSuperviewContentChanged = [](MTView* view) {};
-   std::function<void(MTView*, int)> onKeyPressed = [](MTView* view, int key) {};
-   std::function<void(MTView*, int)> onKeyReleased = [](MTView* view, int key) {};
-   std::function<void(MTView*, int, int)> onMouseMoved = [](MTView* view, int x, int y) {};
-   std::function<void(MTView*, int, int, int)> onMouseDragged = [](MTView* view, int x, int y, int button) {};
-   std::function<void(MTView*, int, int, int)> onMousePressed = [](MTView* view, int x, int y, int button) {};
-   std::function<void(MTView*, int, int, int)> onMouseReleased = [](MTView*, int x, int y, int button) {};
-   std::function<void(MTView*, int, int, float, float)> onMouseScrolled =
-       [](MTView* view, int x, int y, float scrollX, float scrollY) {};
-   std::function<void(MTView*, int, int)> onMouseEntered = [](MTView* view, int x, int y) {};
-   std::function<void(MTView*, int, int)> onMouseExited = [](MTView* view, int x, int y) {};
+   struct Callbacks
+   {
+      std::function<void(MTView*)> onModelLoaded;
+      std::function<void(MTView*)> onSetup;
+      std::function<void(MTView*)> onUpdate;
+      std::function<void(MTView*)> onDraw;
+      std::function<void(MTView*)> onExit;
+      std::function<void(MTView*, int, int)> onWindowResized;
+      std::function<void(MTView*)> onSuperviewFrameChanged;
+      std::function<void(MTView*)> onFrameChanged;
+      std::function<void(MTView*)> onSuperviewContentChanged;
+      std::function<void(MTView*, int)> onKeyPressed;
+      std::function<void(MTView*, int)> onKeyReleased;
+      std::function<void(MTView*, int, int)> onMouseMoved;
+      std::function<void(MTView*, int, int, int)> onMouseDragged;
+      std::function<void(MTView*, int, int, int)> onMousePressed;
+      std::function<void(MTView*, int, int, int)> onMouseReleased;
+      std::function<void(MTView*, int, int, float, float)> onMouseScrolled;
+      std::function<void(MTView*, int, int)> onMouseEntered;
+      std::function<void(MTView*, int, int)> onMouseExited;
+      /// \brief lambda flavor of layout()
+      std::function<void()> onLayout;
+      /// \brief lambda flavor of drawGui()
+      std::function<void()> onDrawGui;
+   };
+
+   /**
+	 * @brief Returns this view's event lambdas, allocating the table on first use.
+	 */
+   Callbacks& callbacks();
+
+   bool hasCallbacks() const
+   {
+      return callbackTable != nullptr;
+   }
+
+ private:
+   std::unique_ptr<Callbacks> callbackTable;
+
+   /// \brief Calls the lambda in `slot` if this view has one.
+   template<typename F, typename... Args>
+   void invokeCallback(F Callbacks::*slot, Args&&... args)
+   {
+      if (!callbackTable) return;
+      auto& f = (*callbackTable).*slot;
+      if (f) f(std::forward<Args>(args)...);
+   }
+
+ public:
 
 
 #pragma mark FRAME AND CONTENT
@@ -395,6 +449,7 @@ class MTView : public MTEventListenerStore
    /// TODO: Delete this method
    const ofRectangle& getScreenFrame()
    {
+      resolveMatrices();
       return screenFrame;
    }
 
@@ -444,6 +499,13 @@ class MTView : public MTEventListenerStore
       return contentMouseUp;
    }
 
+   /// \brief Fills `samples` with the raw mouse samples behind the
+   /// current mouseMoved() or mouseDragged() event, in content coordinates.
+   /// With motion coalescing enabled in the window, these are all the
+   /// positions the mouse reported since the last frame. See
+   /// MTWindow::setMotionCoalescingEnabled().
+   void getContentMouseSamples(std::vector<MTMouseSample>& samples);
+
    const glm::vec2& getContentMouseDragStart()
    {
       return contentMouseDragStart;
@@ -492,6 +554,7 @@ class MTView : public MTEventListenerStore
    /// might result in unexpected behavior!
    glm::mat4& getFrameMatrix()
    {
+      resolveMatrices();
       return frameMatrix;
    }
 
@@ -539,11 +602,36 @@ class MTView : public MTEventListenerStore
 
    void removeAllSubviews(bool recursive = true);
 
+   /**
+	 * @brief Sets whether hit testing uses a spatial index over this view's
+	 * subviews. See MTViewSpatialIndexPolicy.
+	 */
+   void setSpatialIndexPolicy(MTViewSpatialIndexPolicy policy);
+
+   MTViewSpatialIndexPolicy getSpatialIndexPolicy() const
+   {
+      return spatialIndexPolicy;
+   }
+
    std::weak_ptr<MTWindow> getWindow();
 
    int getWindowWidth();
    int getWindowHeight();
 
+ private:
+   MTViewSpatialIndexPolicy spatialIndexPolicy = SpatialIndexAuto;
+   std::unique_ptr<MTViewSpatialIndex> spatialIndex;
+
+   /// \brief Creates or destroys the spatial index according to the policy
+   /// and the number of subviews. Invalidates the index if there is one.
+   void updateSpatialIndex();
+
+   /// \brief Lets the window know that the view hierarchy changed, so that
+   /// it rebuilds its render and GUI lists.
+   void invalidateWindowLists();
+
+ public:
+
 
 #pragma mark VIEW RELATED
    //------------------------------------------------------//
@@ -563,16 +651,55 @@ class MTView : public MTEventListenerStore
    {
    }
 
-   /**
-	  * @brief lambda flavor of layout()
-	  */
-   std::function<void()> onLayout = []() {};
-
    MTViewResizePolicy resizePolicy = ResizePolicyNone;
 
    //This should be private:
    void performResizePolicy();
 
+   /**
+	 * @brief Starts a layout transaction. Until the matching commitLayout(), frame and
+	 * content changes still update the view's rects, but the frameChanged() and
+	 * contentChanged() notifications, resize policies and layout() calls that they
+	 * cause are held back. Transactions nest; only the outermost commitLayout()
+	 * runs the layout pass. Call these from the main thread only.
+	 */
+   static void beginLayout();
+
+   /**
+	 * @brief Ends a layout transaction. The outermost commit runs a single top-down
+	 * pass over the views that changed, shallowest first, so that each view is
+	 * notified and laid out once no matter how many times it changed.
+	 */
+   static void commitLayout();
+
+   static bool isInLayoutTransaction()
+   {
+      return layoutTransactionDepth > 0;
+   }
+
+ private:
+   enum PendingLayoutFlags
+   {
+      PendingFrameChange = 1,
+      PendingContentChange = 2,
+      // Added to a superview: its resize policy and layout() are pending.
+      PendingSuperviewChange = 4
+   };
+
+   static int layoutTransactionDepth;
+   // A min-heap of (depth, view), so that superviews are processed first:
+   static std::vector<std::pair<int, MTView*>> pendingLayoutViews;
+
+   int pendingLayoutFlags = 0;
+
+   /// \brief Defers a change notification if a transaction is open.
+   /// \returns true if the change was deferred.
+   bool deferLayout(int flags);
+   void notifyFrameChanged();
+   void notifyContentChanged();
+
+ public:
+
    /** @brief Enables or disables the drawing of this view's background.
 	 *  The background is the extents of the view's frame.
 	 */
@@ -592,10 +719,34 @@ class MTView : public MTEventListenerStore
    }
 
  private:
-   void drawGuiInternal();
+   /// \brief Calls drawGui() and onDrawGui.
+   /// \returns false if neither of them draws anything.
+   bool drawGuiInternal();
+
+   // Set by the default drawGui(), meaning that this view doesn't override it:
+   bool hasDefaultDrawGui = false;
+   // Whether drawGuiInternal() was called since the view last changed its GUI
+   // callbacks, and what it returned:
+   bool isGuiProbed = false;
+   bool hasGui = false;
+
+   /**
+	 * @brief Draws this view's background and contents, without its subviews,
+	 * using the given absolute matrices. Shared by the recursive draw() and by
+	 * the window's render list.
+	 */
+   void drawContents(const glm::mat4& viewFrameMatrix, const glm::mat4& viewContentMatrix, bool drawViewMode);
  public:
-   virtual void drawGui(){};
-   std::function<void()> onDrawGui = [] {};
+   /**
+	 * @brief Override to draw ImGui widgets. The window finds out which views
+	 * override drawGui() or set onDrawGui the first time it draws them, and
+	 * only visits those afterwards. Overrides should not call this default
+	 * implementation.
+	 */
+   virtual void drawGui()
+   {
+      hasDefaultDrawGui = true;
+   }
 
 
    bool isRenderingEnabled = true;
@@ -698,6 +849,85 @@ class MTView : public MTEventListenerStore
    bool wantsFocus = true;
 
 
+#pragma mark LAYERS
+   //------------------------------------------------------//
+   // LAYERS
+   //------------------------------------------------------//
+
+   /**
+	 * @brief If true, this view renders itself and its subviews into an FBO the
+	 * size of its frame on screen, in pixels, and its superview draws the cached
+	 * texture on every frame, with premultiplied alpha. The subtree is only drawn again when the layer is invalidated, either
+	 * by setNeedsDisplay() or by a change to the frame, the content or the
+	 * subviews of any view in the subtree.
+	 *
+	 * Changes that the framework can't see, such as a new value for a
+	 * variable that your draw() uses, need a call to setNeedsDisplay().
+	 */
+   void setLayerBacked(bool layerBacked);
+
+   bool isLayerBacked() const
+   {
+      return layerBacked;
+   }
+
+   /**
+	 * @brief Invalidates the layer of this view, if it has one, and of every
+	 * layer-backed view above it, and asks the window to draw the next frame if
+	 * it redraws on demand. Cheap if there are no layers.
+	 */
+   void setNeedsDisplay();
+
+ private:
+   bool layerBacked = false;
+   bool layerNeedsDisplay = true;
+   bool isRenderingLayer = false;
+   std::unique_ptr<ofFbo> layer;
+
+   /// \brief Draws the subtree into the layer if it was invalidated, then
+   /// draws the layer's texture in place of the subtree.
+   void drawLayer(ofEventArgs& args);
+
+ public:
+#pragma mark CONCURRENT UPDATES
+   //------------------------------------------------------//
+   // CONCURRENT UPDATES
+   //------------------------------------------------------//
+
+   /**
+	 * @brief If true, the update() of this view and of its whole subtree runs on
+	 * a worker thread instead of the main thread. Each subview is a separate
+	 * task, so sibling subtrees update in parallel. The window waits for all of
+	 * them to finish before it draws.
+	 *
+	 * Only turn this on for views whose update() is pure computation: it
+	 * must not make OpenGL calls, change frames or content, add or remove
+	 * views, call setNeedsDisplay() or touch state shared with other views
+	 * without synchronization. Do any of that in an update or draw operation
+	 * instead; the operation queues of opted-in views are still drained on the
+	 * main thread, before the concurrent update starts.
+	 */
+   void setConcurrentUpdate(bool concurrent)
+   {
+      concurrentUpdate = concurrent;
+   }
+
+   bool getConcurrentUpdate() const
+   {
+      return concurrentUpdate;
+   }
+
+ private:
+   bool concurrentUpdate = false;
+
+   /// \brief Main thread half of a concurrent update: runs the update
+   /// operations of the subtree.
+   void drainUpdateOperations();
+
+   /// \brief Worker thread half of a concurrent update.
+   void updateConcurrently(MTThreadPool::TaskGroup& tasks);
+
+ public:
 #pragma mark OPERATION QUEUES
    //------------------------------------------------------//
    // OPERATION QUEUES
@@ -710,11 +940,13 @@ class MTView : public MTEventListenerStore
 	 * flexible than an ofThreadChannel. If you need to queue one-off slow
 	 * graphics code (i.e. allocating an FBO during runtime), this method
 	 * can make your life a lot less complicated.
+	 * Safe to call from any thread. The function is moved, not copied.
 	 * @param funct
 	 */
-   void enqueueDrawOperation(std::function<void()> funct)
+   template<typename F>
+   void enqueueDrawOperation(F&& funct)
    {
-      drawOpQueue.push(funct);
+      drawOpQueue.enqueue(MTOperation(std::forward<F>(funct)));
    }
 
    /**
@@ -722,11 +954,13 @@ class MTView : public MTEventListenerStore
 	 * draw update. The function is then discarded.
 	 * In views where rendering has been disabled, update() still will be
 	 * called on every frame.
+	 * Safe to call from any thread. The function is moved, not copied.
 	 * @param funct
 	 */
-   void enqueueUpdateOperation(std::function<void()> f)
+   template<typename F>
+   void enqueueUpdateOperation(F&& f)
    {
-      updateOpQueue.push(f);
+      updateOpQueue.enqueue(MTOperation(std::forward<F>(f)));
    }
 
 
@@ -754,8 +988,26 @@ class MTView : public MTEventListenerStore
    ofParameter<float> contentScaleY;
 
 
+   /**
+	 * @brief Recomputes the matrices of this view immediately. You normally don't
+	 * need to call this, matrices are resolved lazily by the window once per frame
+	 * or whenever one of the matrix getters is called.
+	 */
    void updateMatrices();
 
+   /**
+	 * @brief Marks the matrices of this view and its subviews as stale. Nothing is
+	 * recomputed until the matrices are needed.
+	 */
+   void invalidateMatrices();
+
+   /**
+	 * @brief Recomputes the matrices of this view (and of its ancestors) if they
+	 * are stale. Inverse matrices are not computed here, they are computed
+	 * on demand by their getters.
+	 */
+   void resolveMatrices() const;
+
    /**
 	 * @brief An FPS Counter for debugging or any other purposes. Call counter.newFrame()
 	 * to make use of it, and counter.getFPS() to obtain the measured framerate.
@@ -768,11 +1020,51 @@ class MTView : public MTEventListenerStore
    // VIEW and MATRICES
    //------------------------------------------------------//
 
-   glm::mat4 contentMatrix;
-   glm::mat4 invContentMatrix;
-   glm::mat4 frameMatrix;
-   glm::mat4 invFrameMatrix;
+   mutable glm::mat4 contentMatrix;
+   mutable glm::mat4 invContentMatrix;
+   mutable glm::mat4 frameMatrix;
+   mutable glm::mat4 invFrameMatrix;
+
+   // Dirty flags. If a view's matrices are dirty, the matrices of all of its
+   // subviews are dirty too.
+   mutable bool matricesDirty = true;
+   mutable bool invContentMatrixDirty = true;
+   mutable bool invFrameMatrixDirty = true;
+   // True if any view below this one has dirty matrices. Lets the per-frame
+   // resolve pass skip clean branches.
+   bool subviewMatricesDirty = false;
+
+   // The union of the screen frames of this view and all of its descendants,
+   // and the number of views in the subtree. Used for culling.
+   ofRectangle subtreeBounds;
+   size_t subtreeSize = 1;
+   bool subtreeBoundsDirty = true;
+
+   // For the window's partial redraw: where the subtree was when it was last
+   // drawn, and whether the window holds a pointer to this view in its list of
+   // damaged views.
+   ofRectangle drawnBounds;
+   bool isDamagePending = false;
+
+   void invalidateSubtreeBounds();
+   /// \brief Takes this view out of its window's list of damaged views.
+   void forgetDamage();
+
+   void markMatricesDirty();
+
  public:
+   /**
+	 * @brief Resolves the stale matrices of this view and its subviews. Called
+	 * once per frame by the MTWindow before drawing. Clean branches are skipped.
+	 */
+   void resolveSubviewMatrices();
+
+   /**
+	 * @brief The union of the screen frames of this view and all of its
+	 * descendants. Cached, and recomputed only after a change in the subtree.
+	 */
+   const ofRectangle& getSubtreeScreenBounds();
+
    const ofParameter<ofFloatColor>& getBackgroundColor() const;
 
    const glm::mat4& getContentMatrix() const;
@@ -782,9 +1074,7 @@ class MTView : public MTEventListenerStore
    const glm::mat4& getInvFrameMatrix() const;
 
  private:
-   ofRectangle screenFrame;  // The Frame in screen coordinates and scale
-
-   void updateScreenFrame();
+   mutable ofRectangle screenFrame;  // The Frame in screen coordinates and scale
 
    bool isDrawingBackground = true;
    bool isImGuiEnabled = false;
@@ -828,8 +1118,8 @@ class MTView : public MTEventListenerStore
    // QUEUES
    //------------------------------------------------------//
 
-   std::queue<std::function<void()>> updateOpQueue;
-   std::queue<std::function<void()>> drawOpQueue;
+   MTOperationQueue updateOpQueue;
+   MTOperationQueue drawOpQueue;
 
    //------------------------------------------------------//
    // INTERNALS / CONVENIENCE
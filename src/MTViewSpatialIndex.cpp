@@ -0,0 +1,173 @@
+//
+//  MTViewSpatialIndex.cpp
+//
+//  Created by Cristobal Mendoza.
+//
+
+#include "MTViewSpatialIndex.hpp"
+#include "MTView.hpp"
+
+size_t MTViewSpatialIndex::AutoThreshold = 64;
+
+MTView* MTViewSpatialIndex::query(const glm::vec2& point, const std::vector<std::shared_ptr<MTView>>& views)
+{
+   if (!isValid)
+   {
+      rebuild(views);
+   }
+   else if (!dirtyEntries.empty())
+   {
+      for (auto slot : dirtyEntries)
+      {
+         refreshEntry(slot);
+      }
+      dirtyEntries.clear();
+   }
+
+   if (cells.empty()) return nullptr;
+
+   // Slots are indices into the subview vector, so the highest slot that
+   // contains the point is the topmost view:
+   int best = -1;
+   for (auto slot : cells[cellY(point.y) * cols + cellX(point.x)])
+   {
+      if ((int)slot > best && entries[slot].rect.inside(point))
+      {
+         best = slot;
+      }
+   }
+
+   return best >= 0 ? entries[best].view : nullptr;
+}
+
+void MTViewSpatialIndex::invalidate()
+{
+   isValid = false;
+   dirtyEntries.clear();
+}
+
+void MTViewSpatialIndex::invalidate(const MTView* view)
+{
+   if (!isValid) return;
+
+   auto it = slots.find(view);
+   if (it == slots.end())
+   {
+      invalidate();
+      return;
+   }
+
+   dirtyEntries.push_back(it->second);
+
+   // Past this point a rebuild is cheaper than re-binning one by one:
+   if (dirtyEntries.size() > entries.size() / 2)
+   {
+      invalidate();
+   }
+}
+
+void MTViewSpatialIndex::rebuild(const std::vector<std::shared_ptr<MTView>>& views)
+{
+   entries.clear();
+   slots.clear();
+   cells.clear();
+   dirtyEntries.clear();
+   cols = rows = 0;
+   isValid = true;
+
+   if (views.empty()) return;
+
+   entries.reserve(views.size());
+   slots.reserve(views.size());
+
+   float minX = std::numeric_limits<float>::max();
+   float minY = std::numeric_limits<float>::max();
+   float maxX = std::numeric_limits<float>::lowest();
+   float maxY = std::numeric_limits<float>::lowest();
+
+   for (uint32_t i = 0; i < views.size(); i++)
+   {
+      auto& sv = views[i];
+      Entry e;
+      e.view = sv.get();
+      e.rect = sv->getScreenFrame();
+      minX = std::min(minX, e.rect.getMinX());
+      minY = std::min(minY, e.rect.getMinY());
+      maxX = std::max(maxX, e.rect.getMaxX());
+      maxY = std::max(maxY, e.rect.getMaxY());
+      entries.push_back(e);
+      slots[e.view] = i;
+   }
+
+   bounds.set(minX, minY, maxX - minX, maxY - minY);
+
+   // Aim for roughly one view per cell, with cells shaped like the bounds:
+   float n = entries.size();
+   float aspect = bounds.height > 0 ? bounds.width / bounds.height : 1;
+   cols = ofClamp(std::sqrt(n * aspect), 1, 256);
+   rows = ofClamp(n / cols, 1, 256);
+   invCellWidth = bounds.width > 0 ? cols / bounds.width : 0;
+   invCellHeight = bounds.height > 0 ? rows / bounds.height : 0;
+   cells.resize(cols * rows);
+
+   for (uint32_t i = 0; i < entries.size(); i++)
+   {
+      insert(i);
+   }
+}
+
+void MTViewSpatialIndex::refreshEntry(uint32_t slot)
+{
+   remove(slot);
+   auto& e = entries[slot];
+   e.rect = e.view->getScreenFrame();
+   insert(slot);
+}
+
+void MTViewSpatialIndex::insert(uint32_t slot)
+{
+   auto& e = entries[slot];
+   e.x0 = cellX(e.rect.getMinX());
+   e.x1 = cellX(e.rect.getMaxX());
+   e.y0 = cellY(e.rect.getMinY());
+   e.y1 = cellY(e.rect.getMaxY());
+
+   for (int y = e.y0; y <= e.y1; y++)
+   {
+      for (int x = e.x0; x <= e.x1; x++)
+      {
+         cells[y * cols + x].push_back(slot);
+      }
+   }
+}
+
+void MTViewSpatialIndex::remove(uint32_t slot)
+{
+   auto& e = entries[slot];
+   for (int y = e.y0; y <= e.y1; y++)
+   {
+      for (int x = e.x0; x <= e.x1; x++)
+      {
+         auto& cell = cells[y * cols + x];
+         auto it = std::find(cell.begin(), cell.end(), slot);
+         if (it != cell.end())
+         {
+            // Order within a cell doesn't matter:
+            *it = cell.back();
+            cell.pop_back();
+         }
+      }
+   }
+}
+
+// Views that moved outside of the bounds after the last rebuild end up in
+// the edge cells, as do queries outside of the bounds.
+int MTViewSpatialIndex::cellX(float x) const
+{
+   return ofClamp(std::floor((x - bounds.x) * invCellWidth), 0, cols - 1);
+}
+
+int MTViewSpatialIndex::cellY(float y) const
+{
+   return ofClamp(std::floor((y - bounds.y) * invCellHeight), 0, rows - 1);
+}
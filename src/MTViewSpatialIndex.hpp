@@ -0,0 +1,82 @@
+//
+//  MTViewSpatialIndex.hpp
+//
+//  Created by Cristobal Mendoza.
+//
+
+#ifndef MTViewSpatialIndex_hpp
+#define MTViewSpatialIndex_hpp
+
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include "ofRectangle.h"
+
+class MTView;
+
+/**
+ * @brief A uniform grid over the screen frames of the subviews of a view.
+ * MTView::hitTest uses it to find the topmost subview under a point without
+ * scanning every subview.
+ *
+ * The index is lazy: invalidating it is cheap, and the grid is brought up to
+ * date the next time it is queried. Invalidating a single subview (because it
+ * moved or resized) only re-bins that subview; invalidating the whole index
+ * (because subviews were added or removed, or because the owning view moved)
+ * rebuilds the grid from scratch.
+ */
+class MTViewSpatialIndex
+{
+ public:
+   /**
+	 * @brief Views with more subviews than this get an index automatically,
+	 * unless their policy says otherwise.
+	 */
+   static size_t AutoThreshold;
+
+   /**
+	 * @brief Returns the topmost view in `views` whose screen frame contains
+	 * `point`, or nullptr if there is none. `views` must be the same subview
+	 * vector the index was built from, in z-order (last is topmost).
+	 */
+   MTView* query(const glm::vec2& point, const std::vector<std::shared_ptr<MTView>>& views);
+
+   /**
+	 * @brief Marks the whole index as stale. It will be rebuilt on the next query.
+	 */
+   void invalidate();
+
+   /**
+	 * @brief Marks the entry for a single view as stale. Only that view is re-binned
+	 * on the next query.
+	 */
+   void invalidate(const MTView* view);
+
+ private:
+   struct Entry
+   {
+      MTView* view;
+      ofRectangle rect;
+      int x0, y0, x1, y1;  // Cell range, inclusive
+   };
+
+   std::vector<Entry> entries;
+   std::unordered_map<const MTView*, uint32_t> slots;
+   std::vector<std::vector<uint32_t>> cells;
+   std::vector<uint32_t> dirtyEntries;
+   ofRectangle bounds;
+   int cols = 0;
+   int rows = 0;
+   float invCellWidth = 0;
+   float invCellHeight = 0;
+   bool isValid = false;
+
+   void rebuild(const std::vector<std::shared_ptr<MTView>>& views);
+   void refreshEntry(uint32_t slot);
+   void insert(uint32_t slot);
+   void remove(uint32_t slot);
+   int cellX(float x) const;
+   int cellY(float y) const;
+};
+
+#endif /* MTViewSpatialIndex_hpp */
@@ -36,11 +36,17 @@ MTWindow::~MTWindow()
    //	contentView->removeAllSubviews();
    glfwSetCursorPosCallback(getGLFWWindow(), NULL);
    glfwSetWindowFocusCallback(getGLFWWindow(), NULL);
+   glfwSetMouseButtonCallback(getGLFWWindow(), NULL);
+   glfwSetScrollCallback(getGLFWWindow(), NULL);
+   glfwSetKeyCallback(getGLFWWindow(), NULL);
+   glfwSetCharCallback(getGLFWWindow(), NULL);
    ofLogVerbose("MTWindow") << name.get() << " destroyed";
 }
 
 void MTWindow::close()
 {
+   renderList.clear();
+   guiViews.clear();
    if (contentView)
    {
       contentView->removeAllSubviews();
@@ -49,6 +55,10 @@ void MTWindow::close()
 
    glfwSetCursorPosCallback(getGLFWWindow(), NULL);
    glfwSetWindowFocusCallback(getGLFWWindow(), NULL);
+   glfwSetMouseButtonCallback(getGLFWWindow(), NULL);
+   glfwSetScrollCallback(getGLFWWindow(), NULL);
+   glfwSetKeyCallback(getGLFWWindow(), NULL);
+   glfwSetCharCallback(getGLFWWindow(), NULL);
 
    if (MTApp::Instance())
    {
@@ -82,6 +92,12 @@ void MTWindow::setup(ofGLFWWindowSettings& settings)
    glfwSetCursorPosCallback(getGLFWWindow(), nullptr);
    glfwSetCursorPosCallback(getGLFWWindow(), &MTWindow::mt_motion_cb);
    glfwSetWindowFocusCallback(getGLFWWindow(), &MTWindow::mt_focus_callback);
+   // Button, scroll and key events go through us first, so that coalesced
+   // motion that happened before them is delivered before them:
+   ofMouseButtonCallback = glfwSetMouseButtonCallback(getGLFWWindow(), &MTWindow::mt_mouse_button_cb);
+   ofScrollCallback = glfwSetScrollCallback(getGLFWWindow(), &MTWindow::mt_scroll_cb);
+   ofKeyCallback = glfwSetKeyCallback(getGLFWWindow(), &MTWindow::mt_keyboard_cb);
+   ofCharCallback = glfwSetCharCallback(getGLFWWindow(), &MTWindow::mt_char_cb);
 
    //
    //addEventListener(events().windowMoved.newListener(
@@ -124,18 +140,359 @@ void MTWindow::setupInternal(ofEventArgs& args)
 
 void MTWindow::update(ofEventArgs& args)
 {
-   while (!updateOpQueue.empty())
+   MT_PROFILE_SCOPE_LABEL("MTWindow::update", name.get());
+   if (isLayoutDeferred)
    {
-      auto op = updateOpQueue.front();
-      op();
-      updateOpQueue.pop();
+      MTView::beginLayout();
+      if (hasPendingResize)
+      {
+         hasPendingResize = false;
+         applyResize(pendingResize);
+      }
+   }
+
+   flushMotion();
+
+   {
+      MT_PROFILE_SCOPE("MTWindow update ops");
+      updateOpQueue.drain();
    }
 
    contentView->update(args);
+
+   // Views that update concurrently must be done before anything draws or
+   // changes the layout:
+   {
+      MT_PROFILE_SCOPE("MTWindow concurrent update wait");
+      updateTasks.wait();
+   }
+
+   if (isLayoutDeferred)
+   {
+      MTView::commitLayout();
+   }
+}
+
+void MTWindow::setRedrawPolicy(MTWindowRedrawPolicy policy)
+{
+   redrawPolicy = policy;
+   setNeedsDisplay();
+   if (redrawPolicy == RedrawOnDemand)
+   {
+      listenToModelParameters();
+   }
+   else
+   {
+      modelParametersListener.unsubscribe();
+   }
+}
+
+void MTWindow::listenToModelParameters()
+{
+   auto model = MTApp::GetModel();
+   if (!model) return;
+   // Parameters may be set from any thread, setNeedsDisplay() is thread-safe:
+   modelParametersListener = model->getParameters().parameterChangedE().newListener(
+       [this](ofAbstractParameter& p) { setNeedsDisplay(); });
+}
+
+void MTWindow::inputReceived()
+{
+   hasGuiInput = true;
+   // Input by itself doesn't damage anything, the views that it changes do:
+   needsDisplay.store(true, std::memory_order_relaxed);
+   if (isImGuiEnabled) pendingInputFrames = 2;
+}
+
+namespace
+{
+// The time all windows spent updating and drawing in the current iteration of
+// the main loop, and whether the last iteration went over the frame budget:
+struct FrameBudget
+{
+   uint64_t loopWorkTime = 0;
+   bool isOverBudget = false;
+   bool isListening = false;
+   ofEventListener loopListener;
+};
+
+FrameBudget& frameBudget()
+{
+   static FrameBudget budget;
+   if (!budget.isListening && ofGetMainLoop())
+   {
+      budget.isListening = true;
+      budget.loopListener = ofGetMainLoop()->loopEvent.newListener(
+          []()
+          {
+             auto& b = frameBudget();
+             float fps = ofGetTargetFrameRate();
+             uint64_t budgetMicros = 1000000 / (fps > 0 ? fps : 60);
+             b.isOverBudget = b.loopWorkTime > budgetMicros;
+             b.loopWorkTime = 0;
+             MTProfiler::markFrame();
+          });
+   }
+   return budget;
+}
+}
+
+bool MTWindow::scheduleFrame()
+{
+   double now = ofGetElapsedTimeMicros() * 1e-6;
+
+   if (now - rateWindowStart >= 1.0)
+   {
+      achievedFrameRate = rateWindowFrames / (now - rateWindowStart);
+      rateWindowStart = now;
+      rateWindowFrames = 0;
+   }
+
+   // The base window shows itself on its first update, so a window that
+   // never ran would stay hidden:
+   if (hasRunFirstFrame)
+   {
+#ifndef TARGET_RASPBERRY_PI
+      if (isWindowIconified() || !glfwGetWindowAttrib(getGLFWWindow(), GLFW_VISIBLE)) return false;
+#endif
+      if (targetFrameRate == 0) return false;
+
+      if (targetFrameRate > 0)
+      {
+         // Main loop iterations don't land exactly on our slots, anything
+         // within half an iteration counts as on time:
+         float loopRate = ofGetTargetFrameRate();
+         double slack = loopRate > 0 ? 0.5 / loopRate : 0.002;
+         if (now + slack < nextFrameTime) return false;
+
+         double period = 1.0 / targetFrameRate;
+         if (priority == WindowPriorityNormal && frameBudget().isOverBudget && now + slack < nextFrameTime + period)
+         {
+            return false;
+         }
+
+         nextFrameTime += period;
+         // Don't try to catch up after a stall:
+         if (nextFrameTime < now - period) nextFrameTime = now + period;
+      }
+   }
+   else
+   {
+      hasRunFirstFrame = true;
+      nextFrameTime = now;
+   }
+
+   rateWindowFrames++;
+   return true;
+}
+
+void MTWindow::update()
+{
+   isFrameDue = scheduleFrame();
+   if (!isFrameDue) return;
+
+   frameStartTime = ofGetElapsedTimeMicros();
+#ifndef TARGET_RASPBERRY_PI
+   ofAppGLFWWindow::update();
+#else
+   ofAppEGLWindow::update();
+#endif
+   frameBudget().loopWorkTime += ofGetElapsedTimeMicros() - frameStartTime;
+}
+
+void MTWindow::draw()
+{
+   if (!isFrameDue) return;
+
+   frameStartTime = ofGetElapsedTimeMicros();
+   drawFrame();
+   frameBudget().loopWorkTime += ofGetElapsedTimeMicros() - frameStartTime;
+}
+
+void MTWindow::drawFrame()
+{
+   if (redrawPolicy == RedrawOnDemand)
+   {
+      bool shouldDraw = needsDisplay.exchange(false, std::memory_order_relaxed) || !drawOpQueue.empty();
+      if (pendingInputFrames > 0)
+      {
+         pendingInputFrames--;
+         shouldDraw = true;
+      }
+
+      if (!shouldDraw)
+      {
+         skippedFrames++;
+         return;
+      }
+   }
+
+   drawnFrames++;
+#ifndef TARGET_RASPBERRY_PI
+   ofAppGLFWWindow::draw();
+#else
+   ofAppEGLWindow::draw();
+#endif
+}
+
+void MTWindow::setPartialRedrawEnabled(bool enabled)
+{
+   isPartialRedraw = enabled;
+   damageRects.clear();
+   for (auto v : damagedViews)
+   {
+      v->isDamagePending = false;
+   }
+   damagedViews.clear();
+   // Views only record where they were drawn with partial redraw enabled:
+   setNeedsDisplay();
+   if (!enabled) canvas.reset();
+}
+
+void MTWindow::addDamageRect(const ofRectangle& windowRect)
+{
+   if (!isPartialRedraw || windowRect.width <= 0 || windowRect.height <= 0) return;
+   damageRects.push_back(windowRect);
+   needsDisplay.store(true, std::memory_order_relaxed);
+}
+
+void MTWindow::addDamagedView(MTView* view)
+{
+   needsDisplay.store(true, std::memory_order_relaxed);
+   if (!isPartialRedraw || view->isDamagePending) return;
+
+   // Where the view was. Where it is now is only known once its matrices are
+   // resolved, right before drawing:
+   addDamageRect(view->drawnBounds);
+   view->isDamagePending = true;
+   damagedViews.push_back(view);
+}
+
+void MTWindow::removeDamagedView(MTView* view)
+{
+   auto it = std::find(damagedViews.begin(), damagedViews.end(), view);
+   if (it != damagedViews.end())
+   {
+      *it = damagedViews.back();
+      damagedViews.pop_back();
+   }
+}
+
+void MTWindow::mergeDamageRects(const ofRectangle& windowRect)
+{
+   // Snap to whole pixels, with a pixel of margin for antialiased edges, and
+   // clip to the window:
+   size_t count = 0;
+   for (auto& r : damageRects)
+   {
+      float x0 = std::floor(r.getMinX()) - 1;
+      float y0 = std::floor(r.getMinY()) - 1;
+      float x1 = std::ceil(r.getMaxX()) + 1;
+      float y1 = std::ceil(r.getMaxY()) + 1;
+      auto snapped = ofRectangle(x0, y0, x1 - x0, y1 - y0).getIntersection(windowRect);
+      if (snapped.width > 0 && snapped.height > 0) damageRects[count++] = snapped;
+   }
+   damageRects.resize(count);
+
+   // Merge overlapping rects, so that no pixel is drawn twice:
+   bool didMerge = true;
+   while (didMerge)
+   {
+      didMerge = false;
+      for (size_t i = 0; i < damageRects.size(); i++)
+      {
+         for (size_t j = i + 1; j < damageRects.size(); j++)
+         {
+            if (damageRects[i].intersects(damageRects[j]))
+            {
+               damageRects[i].growToInclude(damageRects[j]);
+               damageRects[j] = damageRects.back();
+               damageRects.pop_back();
+               didMerge = true;
+               j--;
+            }
+         }
+      }
+   }
+
+   // Every rect is a full pass over the view tree:
+   if (damageRects.size() > MaxDamageRects)
+   {
+      auto bounds = damageRects.front();
+      for (auto& r : damageRects)
+      {
+         bounds.growToInclude(r);
+      }
+      damageRects.assign(1, bounds);
+   }
+}
+
+void MTWindow::drawDamage(ofEventArgs& args)
+{
+   auto size = getWindowSize();
+   ofRectangle windowRect(0, 0, size.x, size.y);
+
+   if (!canvas || canvas->getWidth() != (int) size.x || canvas->getHeight() != (int) size.y)
+   {
+      canvas = std::make_unique<ofFbo>();
+      canvas->allocate(size.x, size.y, GL_RGBA);
+      needsFullRedraw = true;
+   }
+
+   for (auto v : damagedViews)
+   {
+      v->isDamagePending = false;
+      addDamageRect(v->getSubtreeScreenBounds());
+   }
+   damagedViews.clear();
+
+   if (needsFullRedraw.exchange(false, std::memory_order_relaxed))
+   {
+      damageRects.assign(1, windowRect);
+   }
+   else
+   {
+      mergeDamageRects(windowRect);
+   }
+
+   redrawnPixels = 0;
+   if (!damageRects.empty())
+   {
+      resetClipping();
+      // The canvas is in window coordinates, but as an FBO its scissor boxes
+      // aren't flipped:
+      pushRenderTarget(glm::mat4(1.0f), size.y, windowRect, false);
+      canvas->begin();
+      // Culling against the clip rect is what skips the views outside of
+      // each damaged rect:
+      bool wasCulling = isCulling;
+      isCulling = true;
+      for (auto& rect : damageRects)
+      {
+         pushClipRect(rect);
+         // glClear respects the scissor box:
+         ofClear(backgroundColor);
+         contentView->draw(args);
+         popClipRect();
+         redrawnPixels += (uint64_t) rect.width * rect.height;
+      }
+      isCulling = wasCulling;
+      canvas->end();
+      popRenderTarget();
+      damageRects.clear();
+   }
+
+   resetClipping();
+   ofPushStyle();
+   ofDisableAlphaBlending();
+   ofSetColor(255);
+   canvas->draw(0, 0);
+   ofPopStyle();
 }
 
 void MTWindow::draw(ofEventArgs& args)
 {
+   MT_PROFILE_SCOPE_LABEL("MTWindow::draw", name.get());
    ofClear(backgroundColor);
    ofDisableDepthTest();
 #ifndef TARGET_RASPBERRY_PI
@@ -144,38 +501,326 @@ void MTWindow::draw(ofEventArgs& args)
    ofSetupScreenPerspective(ofAppEGLWindow::getWidth(), ofAppEGLWindow::getHeight());
 #endif
    //ofBackground(backgroundColor);
-   while (!drawOpQueue.empty())
    {
-      auto op = drawOpQueue.front();
-      op();
-      drawOpQueue.pop();
+      MT_PROFILE_SCOPE("MTWindow draw ops");
+      drawOpQueue.drain();
    }
 
    contentView->backgroundColor = backgroundColor;
-   contentView->draw(args);
+
+   resetClipping();
+   frameDrawnViews = 0;
+   frameCulledViews = 0;
+
+   if (isPartialRedraw)
+   {
+      contentView->resolveSubviewMatrices();
+      drawDamage(args);
+   }
+   else if (useRenderList)
+   {
+      if (contentView->matricesDirty || contentView->subviewMatricesDirty)
+      {
+         renderListDirty = true;
+      }
+      contentView->resolveSubviewMatrices();
+      if (renderListDirty) compileRenderList();
+      drawRenderList(args);
+   }
+   else
+   {
+      // Recompute the matrices of every view that changed since the last frame:
+      contentView->resolveSubviewMatrices();
+      contentView->draw(args);
+   }
+
+   drawnViews = frameDrawnViews;
+   culledViews = frameCulledViews;
+   if (!isPartialRedraw)
+   {
+      auto size = getWindowSize();
+      redrawnPixels = (uint64_t) size.x * size.y;
+   }
 
    if (isImGuiEnabled)
    {
       if (ofGetLastFrameTime() != 0.0)
       {
+         MT_PROFILE_SCOPE("ImGui");
          bindImGuiContext();
-         getGui()->begin();
-
-         drawImGuiForView(contentView.get());
-         getGui()->end();
+         if (hasGuiInput || framesUntilGuiRebuild <= 0)
+         {
+            hasGuiInput = false;
+            framesUntilGuiRebuild = guiFrameInterval;
+            getGui()->begin();
+            drawGuiViews();
+            getGui()->end();
+         }
+         framesUntilGuiRebuild--;
+         // Draws the last GUI that was built:
          getGui()->draw();
       }
    }
 }
 
-void MTWindow::drawImGuiForView(MTView* view)
+void MTWindow::setRenderListEnabled(bool enabled)
+{
+   useRenderList = enabled;
+   renderListDirty = true;
+   if (!enabled)
+   {
+      renderList.clear();
+      renderList.shrink_to_fit();
+   }
+}
+
+void MTWindow::compileRenderList()
+{
+   renderList.clear();
+   renderListDirty = false;
+   compileRenderList(contentView, false, ofRectangle());
+}
+
+void MTWindow::compileRenderList(const std::shared_ptr<MTView>& view, bool isClipping, ofRectangle clipRect)
+{
+   if (view->clipToFrame)
+   {
+      clipRect = isClipping ? clipRect.getIntersection(view->getScreenFrame()) : view->getScreenFrame();
+      isClipping = true;
+   }
+
+   // Don't hold a reference to the entry, the recursion below may reallocate:
+   auto index = renderList.size();
+   RenderListEntry entry;
+   entry.view = view;
+   entry.frameMatrix = view->getFrameMatrix();
+   entry.contentMatrix = view->getContentMatrix();
+   entry.clipRect = clipRect;
+   entry.isClipping = isClipping;
+   entry.clipToFrame = view->clipToFrame;
+   entry.isLayer = view->layerBacked;
+   entry.isVisible = view->getSubtreeScreenBounds().intersects(isClipping ? clipRect.getIntersection(cullRect)
+                                                                          : cullRect);
+   entry.isClipEmpty = isClipping && (clipRect.width <= 0 || clipRect.height <= 0);
+   renderList.push_back(entry);
+
+   if (!entry.isLayer)
+   {
+      for (const auto& sv : view->subviews)
+      {
+         compileRenderList(sv, isClipping, clipRect);
+      }
+   }
+
+   renderList[index].subtreeEnd = renderList.size();
+}
+
+void MTWindow::drawRenderList(ofEventArgs& args)
+{
+   bool drawViewModes = MTApp::Instance()->autoDrawViewModes;
+
+   size_t i = 0;
+   while (i < renderList.size())
+   {
+      const auto& entry = renderList[i];
+      auto view = entry.view.get();
+
+      // If a view changed the hierarchy or moved a view earlier in this pass, the
+      // list is stale until the next frame. Skip views that were removed from
+      // the window, and ask the rest for their current matrices:
+      bool isStale = renderListDirty;
+      if (!view->isRenderingEnabled || (isStale && view->window.expired()))
+      {
+         i = entry.subtreeEnd;
+         continue;
+      }
+
+      if ((isCulling && !entry.isVisible) || entry.isClipEmpty)
+      {
+         frameCulledViews += entry.subtreeEnd - i;
+         i = entry.subtreeEnd;
+         continue;
+      }
+      frameDrawnViews++;
+
+      if (view->clipToFrame != entry.clipToFrame || view->layerBacked != entry.isLayer)
+      {
+         renderListDirty = true;
+      }
+
+      // Entries already hold the intersection of all of their clip rects:
+      setClipRect(entry.isClipping, entry.clipRect);
+
+      ofPushMatrix();
+      if (entry.isLayer)
+      {
+         view->drawLayer(args);
+      }
+      else if (isStale)
+      {
+         view->drawContents(view->getFrameMatrix(), view->getContentMatrix(), drawViewModes);
+      }
+      else
+      {
+         view->drawContents(entry.frameMatrix, entry.contentMatrix, drawViewModes);
+      }
+      ofPopMatrix();
+
+      if (contentView->matricesDirty || contentView->subviewMatricesDirty)
+      {
+         renderListDirty = true;
+      }
+
+      i++;
+   }
+
+   setClipRect(false, ofRectangle());
+}
+
+void MTWindow::resetClipping()
+{
+   auto size = getWindowSize();
+   currentTarget.windowToTarget = glm::mat4(1.0f);
+   currentTarget.height = size.y;
+   currentTarget.flipY = isWindowTargetFlipped;
+   currentTarget.bounds.set(0, 0, size.x, size.y);
+   currentTarget.clipStack.clear();
+   savedTargets.clear();
+   cullRect = currentTarget.bounds;
+
+   // We can't know what happened to the GL state since the last frame:
+   glDisable(GL_SCISSOR_TEST);
+   isScissorEnabled = false;
+   scissorBox = ofRectangle(0, 0, -1, -1);
+}
+
+bool MTWindow::pushClipRect(const ofRectangle& windowRect)
+{
+   auto& stack = currentTarget.clipStack;
+   auto rect = (stack.empty() ? currentTarget.bounds : stack.back()).getIntersection(windowRect);
+   stack.push_back(rect);
+   cullRect = rect;
+   bool isEmpty = rect.width <= 0 || rect.height <= 0;
+   if (!isEmpty) applyScissor(true, rect);
+   return !isEmpty;
+}
+
+void MTWindow::popClipRect()
+{
+   auto& stack = currentTarget.clipStack;
+   if (stack.empty()) return;
+
+   stack.pop_back();
+   if (stack.empty())
+   {
+      cullRect = currentTarget.bounds;
+      applyScissor(false, cullRect);
+   }
+   else
+   {
+      cullRect = stack.back();
+      applyScissor(true, cullRect);
+   }
+}
+
+void MTWindow::setClipRect(bool enabled, const ofRectangle& windowRect)
+{
+   auto& stack = currentTarget.clipStack;
+   stack.clear();
+   if (enabled) stack.push_back(windowRect);
+   cullRect = enabled ? windowRect : currentTarget.bounds;
+   applyScissor(enabled, windowRect);
+}
+
+void MTWindow::pushRenderTarget(const glm::mat4& windowToTarget,
+                                float targetHeight,
+                                const ofRectangle& targetBounds,
+                                bool flipY)
+{
+   savedTargets.push_back(std::move(currentTarget));
+   currentTarget = RenderTarget();
+   currentTarget.windowToTarget = windowToTarget;
+   currentTarget.height = targetHeight;
+   currentTarget.flipY = flipY;
+   currentTarget.bounds = targetBounds;
+   cullRect = targetBounds;
+   applyScissor(false, cullRect);
+}
+
+void MTWindow::popRenderTarget()
+{
+   if (savedTargets.empty()) return;
+
+   currentTarget = std::move(savedTargets.back());
+   savedTargets.pop_back();
+   auto& stack = currentTarget.clipStack;
+   cullRect = stack.empty() ? currentTarget.bounds : stack.back();
+   applyScissor(!stack.empty(), cullRect);
+}
+
+void MTWindow::applyScissor(bool enabled, const ofRectangle& windowRect)
+{
+   if (!enabled)
+   {
+      if (isScissorEnabled)
+      {
+         glDisable(GL_SCISSOR_TEST);
+         isScissorEnabled = false;
+      }
+      return;
+   }
+
+   // Transform to the target's coordinates, and flip Y unless it's an FBO:
+   auto p0 = currentTarget.windowToTarget * glm::vec4(windowRect.getMinX(), windowRect.getMinY(), 0, 1);
+   auto p1 = currentTarget.windowToTarget * glm::vec4(windowRect.getMaxX(), windowRect.getMaxY(), 0, 1);
+   float x0 = std::round(std::min(p0.x, p1.x));
+   float x1 = std::round(std::max(p0.x, p1.x));
+   float y0 = std::round(std::min(p0.y, p1.y));
+   float y1 = std::round(std::max(p0.y, p1.y));
+   ofRectangle box(x0, currentTarget.flipY ? currentTarget.height - y1 : y0, x1 - x0, y1 - y0);
+
+   if (!isScissorEnabled)
+   {
+      glEnable(GL_SCISSOR_TEST);
+      isScissorEnabled = true;
+   }
+   if (box != scissorBox)
+   {
+      glScissor(box.x, box.y, box.width, box.height);
+      scissorBox = box;
+   }
+}
+
+void MTWindow::drawGuiViews()
+{
+   if (guiListDirty)
+   {
+      guiListDirty = false;
+      guiViews.clear();
+      compileGuiList(contentView.get());
+   }
+
+   for (auto view : guiViews)
+   {
+      bool hasGui = view->drawGuiInternal();
+      if (!view->isGuiProbed)
+      {
+         view->isGuiProbed = true;
+         view->hasGui = hasGui;
+         // Drop the view from the list on the next frame:
+         if (!hasGui) guiListDirty = true;
+      }
+   }
+}
+
+void MTWindow::compileGuiList(MTView* view)
 {
    for (const auto& sv : view->getSubviews())
    {
-      drawImGuiForView(sv.get());
+      compileGuiList(sv.get());
    }
 
-   view->drawGuiInternal();
+   if (!view->isGuiProbed || view->hasGui) guiViews.push_back(view);
 }
 
 void MTWindow::addSubview(std::shared_ptr<MTView> subview)
@@ -204,6 +849,21 @@ const MTView* MTWindow::getRootView()
 //}
 
 void MTWindow::windowResized(ofResizeEventArgs& resize)
+{
+   setNeedsDisplay();
+   hasGuiInput = true;
+   if (isLayoutDeferred)
+   {
+      // Live resizing delivers many of these per frame, only the last one matters:
+      pendingResize = resize;
+      hasPendingResize = true;
+      return;
+   }
+
+   applyResize(resize);
+}
+
+void MTWindow::applyResize(ofResizeEventArgs& resize)
 {
    auto size = this->getWindowSize();
    ofViewport(0, 0, size.x, size.y);
@@ -215,6 +875,7 @@ void MTWindow::windowResized(ofResizeEventArgs& resize)
 
 void MTWindow::keyPressed(ofKeyEventArgs& key)
 {
+   inputReceived();
    if (focusedView)
    {
       focusedView->keyPressedInternal(key);
@@ -225,6 +886,7 @@ void MTWindow::keyPressed(ofKeyEventArgs& key)
 
 void MTWindow::keyReleased(ofKeyEventArgs& key)
 {
+   inputReceived();
    if (focusedView)
    {
       focusedView->keyReleasedInternal(key);
@@ -235,6 +897,7 @@ void MTWindow::keyReleased(ofKeyEventArgs& key)
 
 void MTWindow::mouseMoved(ofMouseEventArgs& mouse)
 {
+   inputReceived();
    auto v = contentView->hitTest(mouse);
    if (mouseOverView)
    {
@@ -256,6 +919,7 @@ void MTWindow::mouseMoved(ofMouseEventArgs& mouse)
 
 void MTWindow::mouseDragged(ofMouseEventArgs& mouse)
 {
+   inputReceived();
    if (!isMouseDragging)
    {
       isMouseDragging = true;
@@ -268,6 +932,7 @@ void MTWindow::mouseDragged(ofMouseEventArgs& mouse)
 
 void MTWindow::mousePressed(ofMouseEventArgs& mouse)
 {
+   inputReceived();
    isMouseDown = true;
    mouseButtonInUse = mouse.button;
    mouseDownPos = glm::vec2(mouse.x, mouse.y);
@@ -278,6 +943,7 @@ void MTWindow::mousePressed(ofMouseEventArgs& mouse)
 
 void MTWindow::mouseReleased(ofMouseEventArgs& mouse)
 {
+   inputReceived();
    isMouseDown = false;
    isMouseDragging = false;
    mouseUpPos = glm::vec2(mouse.x, mouse.y);
@@ -289,6 +955,7 @@ void MTWindow::mouseReleased(ofMouseEventArgs& mouse)
 /// TODO: Scrolling in MTWindow
 void MTWindow::mouseScrolled(ofMouseEventArgs& mouse)
 {
+   inputReceived();
    mouseButtonInUse = mouse.button;
 
    mouseOverView->mouseScrolled(mouse);
@@ -296,16 +963,19 @@ void MTWindow::mouseScrolled(ofMouseEventArgs& mouse)
 
 void MTWindow::mouseEntered(ofMouseEventArgs& mouse)
 {
+   inputReceived();
    mouseButtonInUse = mouse.button;
 }
 
 void MTWindow::mouseExited(ofMouseEventArgs& mouse)
 {
+   inputReceived();
    mouseButtonInUse = mouse.button;
 }
 
 void MTWindow::dragged(ofDragInfo& drag)
 {
+   inputReceived();
 }
 
 void MTWindow::messageReceived(ofMessage& message)
@@ -314,6 +984,9 @@ void MTWindow::messageReceived(ofMessage& message)
 
 void MTWindow::modelLoaded(ofEventArgs& args)
 {
+   setNeedsDisplay();
+   if (redrawPolicy == RedrawOnDemand) listenToModelParameters();
+
    //enqueueUpdateOperation(
    //    [this]()
    //    {
@@ -439,6 +1112,7 @@ void MTWindow::setImGuiEnabled(bool doGui, ImGuiConfigFlags customFlags)
       gui = std::make_shared<ofxImGui::Gui>();
       gui->setup(nullptr, false, customFlags, true, false);
       imCtx = ImGui::GetCurrentContext();
+      framesUntilGuiRebuild = 0;
       //});
    }
    else
@@ -510,18 +1184,63 @@ void MTWindow::mt_motion_cb(GLFWwindow* windowP_, double x, double y)
    auto dims = instance->getWindowSize();
    mt_rotateMouseXY(instance->getOrientation(), dims.x, dims.y, x, y);
 
-   if (!mtWindow->isMouseDown)
+   MTMouseSample sample;
+   sample.position = glm::vec2(x, y) * instance->getPixelScreenCoordScale();
+   sample.time = ofGetElapsedTimeMicros();
+
+   if (mtWindow->isCoalescingMotion)
+   {
+      // A window that isn't updating, because it is paused, iconified or
+      // hidden, still gets motion. Keep only the latest samples:
+      auto& samples = mtWindow->pendingMouseSamples;
+      if (samples.size() >= MaxPendingMouseSamples)
+      {
+         samples.erase(samples.begin(), samples.begin() + MaxPendingMouseSamples / 2);
+      }
+      samples.push_back(sample);
+      mtWindow->hasPendingMotion = true;
+      return;
+   }
+
+   mtWindow->mouseSamples.clear();
+   mtWindow->mouseSamples.push_back(sample);
+   mtWindow->notifyMotion(sample.position.x, sample.position.y);
+}
+
+#endif
+
+void MTWindow::setMotionCoalescingEnabled(bool enabled)
+{
+   if (!enabled) flushMotion();
+   isCoalescingMotion = enabled;
+}
+
+void MTWindow::flushMotion()
+{
+   if (!hasPendingMotion) return;
+   hasPendingMotion = false;
+
+   // Swap so that the buffers keep their capacity from frame to frame:
+   std::swap(mouseSamples, pendingMouseSamples);
+   pendingMouseSamples.clear();
+   auto& last = mouseSamples.back().position;
+   notifyMotion(last.x, last.y);
+}
+
+void MTWindow::notifyMotion(float x, float y)
+{
+   if (!isMouseDown)
    {
-      instance->events().notifyMouseMoved(x * instance->getPixelScreenCoordScale(), y * instance->getPixelScreenCoordScale());
+      events().notifyMouseMoved(x, y);
    }
    else
    {
-      instance->events().notifyMouseDragged(x * instance->getPixelScreenCoordScale(),
-                                            y * instance->getPixelScreenCoordScale(),
-                                            mtWindow->mouseButtonInUse);
+      events().notifyMouseDragged(x, y, mouseButtonInUse);
    }
 }
 
+#ifndef TARGET_RASPBERRY_PI
+
 void MTWindow::mt_focus_callback(GLFWwindow* glfWwindow, int isFocused)
 {
    ofAppGLFWWindow* instance = static_cast<ofAppGLFWWindow*>(glfwGetWindowUserPointer(glfWwindow));
@@ -543,4 +1262,59 @@ void MTWindow::mt_focus_callback(GLFWwindow* glfWwindow, int isFocused)
    }
 }
 
+MTWindow* MTWindow::flushMotionBeforeInput(GLFWwindow* glfwWindow)
+{
+   ofAppGLFWWindow* instance = static_cast<ofAppGLFWWindow*>(glfwGetWindowUserPointer(glfwWindow));
+
+   MTWindow* mtWindow = static_cast<MTWindow*>(instance);
+   if (mtWindow && mtWindow->hasPendingMotion)
+   {
+      std::shared_ptr<ofMainLoop> mainLoop = ofGetMainLoop();
+
+      if (mainLoop)
+      {
+         mainLoop->setCurrentWindow(instance);
+      }
+      instance->makeCurrent();
+      mtWindow->flushMotion();
+   }
+   return mtWindow;
+}
+
+void MTWindow::mt_mouse_button_cb(GLFWwindow* glfwWindow, int button, int action, int mods)
+{
+   MTWindow* mtWindow = flushMotionBeforeInput(glfwWindow);
+   if (mtWindow && mtWindow->ofMouseButtonCallback)
+   {
+      mtWindow->ofMouseButtonCallback(glfwWindow, button, action, mods);
+   }
+}
+
+void MTWindow::mt_scroll_cb(GLFWwindow* glfwWindow, double x, double y)
+{
+   MTWindow* mtWindow = flushMotionBeforeInput(glfwWindow);
+   if (mtWindow && mtWindow->ofScrollCallback)
+   {
+      mtWindow->ofScrollCallback(glfwWindow, x, y);
+   }
+}
+
+void MTWindow::mt_keyboard_cb(GLFWwindow* glfwWindow, int key, int scancode, int action, int mods)
+{
+   MTWindow* mtWindow = flushMotionBeforeInput(glfwWindow);
+   if (mtWindow && mtWindow->ofKeyCallback)
+   {
+      mtWindow->ofKeyCallback(glfwWindow, key, scancode, action, mods);
+   }
+}
+
+void MTWindow::mt_char_cb(GLFWwindow* glfwWindow, uint32_t codepoint)
+{
+   MTWindow* mtWindow = flushMotionBeforeInput(glfwWindow);
+   if (mtWindow && mtWindow->ofCharCallback)
+   {
+      mtWindow->ofCharCallback(glfwWindow, codepoint);
+   }
+}
+
 #endif
@@ -19,12 +19,32 @@
 #endif
 
 #include "ofxImGui.h"
+#include "MTOperationQueue.hpp"
+#include "MTThreadPool.hpp"
 
 //class MTModel;
 //class MTAppModeChangeArgs;
 //class MTView;
 class MTWindowEventArgs;
 
+enum MTWindowRedrawPolicy
+{
+   // Default. Draw every frame.
+   RedrawContinuously = 0,
+
+   // Only draw when something asked for it, otherwise keep showing the last frame.
+   RedrawOnDemand
+};
+
+enum MTWindowPriority
+{
+   // Default. Frames may be postponed when the main loop runs over its budget.
+   WindowPriorityNormal = 0,
+
+   // Frames are never postponed. Meant for output windows.
+   WindowPriorityOutput
+};
+
 #ifndef TARGET_RASPBERRY_PI
 class MTWindow : public ofAppGLFWWindow, public MTEventListenerStore, public std::enable_shared_from_this<MTWindow>
 {
@@ -165,21 +185,25 @@ public:
    //------------------------------------------------------//
 
    /**
-	 * @brief enqueueDrawOperation
+	 * @brief Adds a function that gets executed once, at the start of the window's
+	 * draw. Safe to call from any thread. The function is moved, not copied.
 	 * @param funct
 	 */
-   void enqueueDrawOperation(std::function<void()> funct)
+   template<typename F>
+   void enqueueDrawOperation(F&& funct)
    {
-      drawOpQueue.push(funct);
+      drawOpQueue.enqueue(MTOperation(std::forward<F>(funct)));
    }
 
    /**
-	 * @brief enqueueUpdateOperation
+	 * @brief Adds a function that gets executed once, at the start of the window's
+	 * update. Safe to call from any thread. The function is moved, not copied.
 	 * @param f
 	 */
-   void enqueueUpdateOperation(std::function<void()> f)
+   template<typename F>
+   void enqueueUpdateOperation(F&& f)
    {
-      updateOpQueue.push(f);
+      updateOpQueue.enqueue(MTOperation(std::forward<F>(f)));
    }
 
    //------------------------------------------------------//
@@ -206,6 +230,386 @@ public:
 	 */
    int getHeight() override;
 
+#pragma mark Redraw Policy
+
+   /**
+	 * @brief With RedrawOnDemand, the window skips drawing and swapping buffers
+	 * unless something changed since the last frame: input, a resize, a change
+	 * to a parameter of the app's model, a draw operation enqueued in the
+	 * window or in a view, a frame or content change in any view, or a call to
+	 * setNeedsDisplay() on the window or on a view. update() still runs every
+	 * frame.
+	 *
+	 * Views that animate on their own must call setNeedsDisplay() from
+	 * update() while they animate.
+	 */
+   void setRedrawPolicy(MTWindowRedrawPolicy policy);
+
+   MTWindowRedrawPolicy getRedrawPolicy() const
+   {
+      return redrawPolicy;
+   }
+
+   /**
+	 * @brief Asks the window to draw on the next frame. With partial redraw
+	 * enabled, the whole window is redrawn. Safe to call from any thread.
+	 */
+   void setNeedsDisplay()
+   {
+      needsFullRedraw.store(true, std::memory_order_relaxed);
+      needsDisplay.store(true, std::memory_order_relaxed);
+   }
+
+   /**
+	 * @brief The number of frames drawn, and skipped because nothing changed,
+	 * since the window was created.
+	 */
+   uint64_t getDrawnFrameCount() const
+   {
+      return drawnFrames;
+   }
+
+   uint64_t getSkippedFrameCount() const
+   {
+      return skippedFrames;
+   }
+
+   /**
+	 * @brief Overrides the base window's draw() to skip frames that don't need
+	 * to be drawn.
+	 */
+   void draw() override;
+
+ private:
+   MTWindowRedrawPolicy redrawPolicy = RedrawContinuously;
+   std::atomic<bool> needsDisplay{true};
+   std::atomic<bool> needsFullRedraw{true};
+   // Extra frames to draw after input, for ImGui, which lags input by a frame:
+   int pendingInputFrames = 0;
+   uint64_t drawnFrames = 0;
+   uint64_t skippedFrames = 0;
+   ofEventListener modelParametersListener;
+
+   void inputReceived();
+   void listenToModelParameters();
+
+ public:
+#pragma mark Frame Pacing
+
+   /**
+	 * @brief Limits how often this window updates and draws. The main loop
+	 * still runs at the app's frame rate (see ofSetFrameRate()), which should
+	 * be at least the highest rate of any window; on the loop iterations where
+	 * this window's slot hasn't come up, both its update() and its draw() are
+	 * skipped. A negative rate (the default) runs on every iteration, and 0
+	 * pauses the window. Minimized and hidden windows are always paused.
+	 */
+   void setTargetFrameRate(float fps)
+   {
+      targetFrameRate = fps;
+   }
+
+   float getTargetFrameRate() const
+   {
+      return targetFrameRate;
+   }
+
+   /**
+	 * @brief When the windows took longer than a frame of the main loop to
+	 * update and draw, the next frames of normal priority windows are postponed,
+	 * by up to one of their own frame periods. Output windows are never
+	 * postponed.
+	 */
+   void setPriority(MTWindowPriority priority)
+   {
+      this->priority = priority;
+   }
+
+   MTWindowPriority getPriority() const
+   {
+      return priority;
+   }
+
+   /**
+	 * @brief The number of frames this window actually ran in the last second.
+	 */
+   float getAchievedFrameRate() const
+   {
+      return achievedFrameRate;
+   }
+
+   /**
+	 * @brief Overrides the base window's update() to skip the frames that
+	 * the pacing doesn't schedule.
+	 */
+   void update() override;
+
+ private:
+   float targetFrameRate = -1;
+   MTWindowPriority priority = WindowPriorityNormal;
+   bool hasRunFirstFrame = false;
+   bool isFrameDue = true;
+   // In seconds since the app started:
+   double nextFrameTime = 0;
+   double rateWindowStart = 0;
+   int rateWindowFrames = 0;
+   float achievedFrameRate = 0;
+   uint64_t frameStartTime = 0;
+
+   bool scheduleFrame();
+   /// \brief The redraw policy part of draw().
+   void drawFrame();
+
+ public:
+#pragma mark Partial Redraw
+
+   /**
+	 * @brief When enabled, the window keeps its contents in an offscreen
+	 * buffer and only redraws the areas that changed since the last frame. The
+	 * damaged areas are the old and new screen bounds of the views that called
+	 * setNeedsDisplay(), which MTView does on its own after frame and content
+	 * changes, subview changes and draw operations. Each damaged rect is redrawn
+	 * in a scissored pass that skips the views outside of it, and the buffer is
+	 * then drawn to the window. Disabled by default.
+	 *
+	 * Views whose appearance changes for any other reason, for instance on
+	 * hover, must call setNeedsDisplay() themselves. Views that draw outside of
+	 * their frame may leave stale pixels behind. The render list is not used
+	 * while partial redraw is enabled.
+	 */
+   void setPartialRedrawEnabled(bool enabled);
+
+   bool isPartialRedrawEnabled() const
+   {
+      return isPartialRedraw;
+   }
+
+   /**
+	 * @brief Adds a rect, in window coordinates, to the area redrawn on the next
+	 * frame. Only matters with partial redraw.
+	 */
+   void addDamageRect(const ofRectangle& windowRect);
+
+   /**
+	 * @brief The number of pixels redrawn in the last frame that was drawn.
+	 * With partial redraw disabled, this is the area of the window.
+	 */
+   uint64_t getRedrawnPixelCount() const
+   {
+      return redrawnPixels;
+   }
+
+ private:
+   bool isPartialRedraw = false;
+   // Holds the window's contents between frames:
+   std::unique_ptr<ofFbo> canvas;
+   // Damaged areas known so far, in window coordinates:
+   std::vector<ofRectangle> damageRects;
+   // Views whose new bounds are added to the damage before drawing:
+   std::vector<MTView*> damagedViews;
+   uint64_t redrawnPixels = 0;
+
+   // Past this number the damaged rects are merged into their bounding box:
+   static constexpr size_t MaxDamageRects = 8;
+
+   void addDamagedView(MTView* view);
+   void removeDamagedView(MTView* view);
+   void mergeDamageRects(const ofRectangle& windowRect);
+   void drawDamage(ofEventArgs& args);
+
+ public:
+#pragma mark Layout
+
+   /**
+	 * @brief When enabled, window resizes are applied once per frame at the start of
+	 * update(), using the last size received, and the whole update() runs inside a
+	 * layout transaction (see MTView::beginLayout()). Frame changes made from
+	 * update() are then laid out once, when update() returns. Disabled by default.
+	 */
+   void setLayoutDeferred(bool deferred)
+   {
+      isLayoutDeferred = deferred;
+   }
+
+   bool getLayoutDeferred() const
+   {
+      return isLayoutDeferred;
+   }
+
+ private:
+   bool isLayoutDeferred = false;
+   bool hasPendingResize = false;
+   ofResizeEventArgs pendingResize;
+
+   void applyResize(ofResizeEventArgs& resize);
+
+ public:
+#pragma mark Render List
+
+   /**
+	 * @brief When enabled, the window compiles its view hierarchy into a flat list
+	 * and draws it in one linear pass, instead of recursing through MTView::draw().
+	 * The list is rebuilt only when views are added or removed, or when a frame or
+	 * content rect changes. Disabled by default.
+	 *
+	 * Note that MTView::draw(ofEventArgs&) is not called for views drawn from the
+	 * list, so subclasses that override it won't behave as expected. Nested
+	 * clipping views intersect their clip rects.
+	 */
+   void setRenderListEnabled(bool enabled);
+
+   bool isRenderListEnabled() const
+   {
+      return useRenderList;
+   }
+
+   /**
+	 * @brief Marks the render list as stale. MTView calls this when the hierarchy changes.
+	 */
+   void invalidateRenderList()
+   {
+      renderListDirty = true;
+   }
+
+#pragma mark Clipping
+
+   /**
+	 * @brief Intersects the current clip rect with a rect in window coordinates and
+	 * makes the result the current clip rect and scissor box. Every call must be
+	 * matched by a call to popClipRect(), even if it returns false.
+	 * @return false if the intersection is empty, meaning that nothing drawn until
+	 * popClipRect() would be visible.
+	 */
+   bool pushClipRect(const ofRectangle& windowRect);
+
+   /**
+	 * @brief Restores the clip rect and scissor box that were current before the
+	 * matching pushClipRect().
+	 */
+   void popClipRect();
+
+   /**
+	 * @brief Starts drawing to an offscreen target, such as a view's layer, with an
+	 * empty clip stack of its own. popRenderTarget() restores the previous target's
+	 * clip stack.
+	 * @param windowToTarget Transforms window coordinates to target coordinates.
+	 * @param targetHeight The height of the target in pixels.
+	 * @param targetBounds The area covered by the target, in window coordinates.
+	 * @param flipY Whether the target's rows are stored bottom-first, like the
+	 * window's default framebuffer. ofFbo stores them top-first, so layers and
+	 * other FBO targets pass false.
+	 */
+   void pushRenderTarget(const glm::mat4& windowToTarget,
+                         float targetHeight,
+                         const ofRectangle& targetBounds,
+                         bool flipY = false);
+   void popRenderTarget();
+
+ private:
+   struct RenderListEntry
+   {
+      std::shared_ptr<MTView> view;
+      glm::mat4 frameMatrix;
+      glm::mat4 contentMatrix;
+      // The scissor rect in window coordinates, only valid if isClipping:
+      ofRectangle clipRect;
+      // One past the index of the last entry of this view's subtree:
+      size_t subtreeEnd;
+      bool isClipping;
+      // The value of view->clipToFrame when the list was compiled:
+      bool clipToFrame;
+      // Layer-backed views draw their subtree themselves:
+      bool isLayer;
+      // False if the subtree lies outside of the window or of the clip rect:
+      bool isVisible;
+      // True if the clip rect is empty, in which case nothing in the subtree is drawn:
+      bool isClipEmpty;
+   };
+
+   struct RenderTarget
+   {
+      glm::mat4 windowToTarget;
+      float height;
+      // False for FBOs, whose scissor boxes aren't flipped:
+      bool flipY = true;
+      // The area covered by the target, in window coordinates:
+      ofRectangle bounds;
+      // Each rect is already intersected with the ones below it:
+      std::vector<ofRectangle> clipStack;
+   };
+
+   RenderTarget currentTarget;
+   std::vector<RenderTarget> savedTargets;
+
+   // The GL scissor state, so that redundant state changes can be skipped:
+   bool isScissorEnabled = false;
+   ofRectangle scissorBox;
+
+   void resetClipping();
+   /// \brief Replaces the clip stack with a single rect. Used by the render list.
+   void setClipRect(bool enabled, const ofRectangle& windowRect);
+   void applyScissor(bool enabled, const ofRectangle& windowRect);
+
+   std::vector<RenderListEntry> renderList;
+   bool useRenderList = false;
+   bool renderListDirty = true;
+
+   void compileRenderList();
+   void compileRenderList(const std::shared_ptr<MTView>& view, bool isClipping, ofRectangle clipRect);
+   void drawRenderList(ofEventArgs& args);
+
+ public:
+
+#pragma mark Culling
+
+   /**
+	 * @brief When enabled, views whose subtree lies entirely outside of the window,
+	 * or outside of a clipping ancestor, are not drawn. Subtrees are tested against
+	 * the union of their screen frames, so views that draw outside of their
+	 * frame without clipping might be culled while partially visible. Disabled by
+	 * default.
+	 */
+   void setCullingEnabled(bool enabled)
+   {
+      isCulling = enabled;
+   }
+
+   bool isCullingEnabled() const
+   {
+      return isCulling;
+   }
+
+   /**
+	 * @brief The number of views drawn in the last frame.
+	 */
+   size_t getDrawnViewCount() const
+   {
+      return drawnViews;
+   }
+
+   /**
+	 * @brief The number of views skipped by culling in the last frame.
+	 */
+   size_t getCulledViewCount() const
+   {
+      return culledViews;
+   }
+
+ private:
+   friend class MTView;
+
+   bool isCulling = false;
+   // The rect that subtrees are culled against, in window coordinates:
+   ofRectangle cullRect;
+   size_t drawnViews = 0;
+   size_t culledViews = 0;
+   size_t frameDrawnViews = 0;
+   size_t frameCulledViews = 0;
+
+   // Concurrent view updates of the current frame:
+   MTThreadPool::TaskGroup updateTasks;
+
+ public:
 
 #pragma mark ImGui
 
@@ -229,21 +633,49 @@ public:
 
    void close() override;
 
+   /**
+	 * @brief Rebuilds the GUI only once every `interval` frames, and draws the
+	 * previous GUI in the frames in between. Frames with input always rebuild
+	 * the GUI, so it stays responsive. Useful when heavy inspector panels cost
+	 * more than the scene. The default of 1 rebuilds on every frame.
+	 */
+   void setGuiFrameInterval(int interval)
+   {
+      guiFrameInterval = std::max(interval, 1);
+   }
+
+   int getGuiFrameInterval() const
+   {
+      return guiFrameInterval;
+   }
+
  protected:
    /**
-	 * @brief Recursively calls drawGui() on this view and all of its subviews
-	 * @param view
+	 * @brief Calls drawGui() on the views that draw a GUI, in the same order as
+	 * a depth-first walk that visits subviews before their superview.
 	 */
-   void drawImGuiForView(MTView* view);
+   void drawGuiViews();
    bool isImGuiEnabled = false;
    ImGuiContext* imCtx;
    std::shared_ptr<ofxImGui::Gui> gui;
 
+ private:
+   // The views that draw a GUI, plus the ones that haven't been asked yet:
+   std::vector<MTView*> guiViews;
+   bool guiListDirty = true;
+   int guiFrameInterval = 1;
+   int framesUntilGuiRebuild = 0;
+   bool hasGuiInput = false;
+
+   void compileGuiList(MTView* view);
+
 #pragma mark Internals
 
  protected:
    void removeAllEvents();
    void addAllEvents();
+   /// False if the window draws into an FBO instead of its framebuffer.
+   bool isWindowTargetFlipped = true;
 
  private:
    /// This function is called internally by the framework to signal that a
@@ -257,8 +689,8 @@ public:
    ofMatrix4x4 transMatrix;
    ofMatrix4x4 invTransMatrix;  // Just a cached value
 
-   std::queue<std::function<void()>> updateOpQueue;
-   std::queue<std::function<void()>> drawOpQueue;
+   MTOperationQueue updateOpQueue;
+   MTOperationQueue drawOpQueue;
 
    MTView* focusedView;
    MTView* mouseOverView;
@@ -273,6 +705,63 @@ public:
    glm::vec2 mouseUpPos;
    glm::vec2 mouseDragStart;
 
+#pragma mark MOUSE MOTION
+
+ public:
+   /**
+	 * @brief If true, mouse motion is delivered at most once per frame, at the
+	 * start of update(), instead of once for every position the mouse reports.
+	 * Views get a single mouseMoved() or mouseDragged() with the latest
+	 * position, and can read the positions since the previous frame, up to
+	 * the latest 1024, with getMouseSamples(). Pending motion is flushed as soon as a button, scroll
+	 * or key event arrives from GLFW, before any listener sees that event, so
+	 * events keep their order. Off by default.
+	 */
+   void setMotionCoalescingEnabled(bool enabled);
+
+   bool isMotionCoalescingEnabled() const
+   {
+      return isCoalescingMotion;
+   }
+
+   /**
+	 * @brief The raw samples behind the mouse motion event being delivered, in
+	 * window coordinates and oldest first. Without coalescing this is just the
+	 * position of the current event. Only valid during mouseMoved() and
+	 * mouseDragged().
+	 */
+   const std::vector<MTMouseSample>& getMouseSamples() const
+   {
+      return mouseSamples;
+   }
+
+ private:
+   bool isCoalescingMotion = false;
+   bool hasPendingMotion = false;
+   // Samples received since the last flush, at most MaxPendingMouseSamples:
+   std::vector<MTMouseSample> pendingMouseSamples;
+   static const size_t MaxPendingMouseSamples = 1024;
+   // Samples of the event being delivered:
+   std::vector<MTMouseSample> mouseSamples;
+
+   /// \brief Delivers the pending coalesced motion, if there is any.
+   void flushMotion();
+   void notifyMotion(float x, float y);
+
+#ifndef TARGET_RASPBERRY_PI
+   // ofAppGLFWWindow's own callbacks, which ours chain to after flushing:
+   GLFWmousebuttonfun ofMouseButtonCallback = nullptr;
+   GLFWscrollfun ofScrollCallback = nullptr;
+   GLFWkeyfun ofKeyCallback = nullptr;
+   GLFWcharfun ofCharCallback = nullptr;
+
+   /// \brief Flushes the motion that arrived before an input event from
+   /// GLFW, so that ofCoreEvents and its listeners see it first.
+   static MTWindow* flushMotionBeforeInput(GLFWwindow* glfwWindow);
+#endif
+
+ public:
+
 
 #ifndef TARGET_RASPBERRY_PI
    /**
@@ -282,6 +771,10 @@ public:
 	 */
    static void mt_motion_cb(GLFWwindow* windowP_, double x, double y);
    static void mt_focus_callback(GLFWwindow* glfWwindow, int isFocused);
+   static void mt_mouse_button_cb(GLFWwindow* glfwWindow, int button, int action, int mods);
+   static void mt_scroll_cb(GLFWwindow* glfwWindow, double x, double y);
+   static void mt_keyboard_cb(GLFWwindow* glfwWindow, int key, int scancode, int action, int mods);
+   static void mt_char_cb(GLFWwindow* glfwWindow, uint32_t codepoint);
 #endif
 };
 